@@ -0,0 +1,16 @@
+QT       += core gui
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets printsupport concurrent
+
+TARGET = binary-encoding-bench
+TEMPLATE = app
+
+CONFIG += console c++17
+CONFIG -= app_bundle
+
+include(../encoder.pri)
+
+SOURCES += main.cpp \
+    ../qcustomplot/qcustomplot.cpp
+
+HEADERS += ../qcustomplot/qcustomplot.h
@@ -0,0 +1,404 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2015 Christian González León
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+  */
+
+// Benchmarks of the encoders, the hexadecimal conversions and the plots at message sizes from 64
+// bits to 100 million, written as JSON to compare runs
+
+#include "binaryencoder.h"
+#include "hexconversion.h"
+#include "qcustomplot/qcustomplot.h"
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QList>
+#include <QPair>
+#include <QThread>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#if defined(Q_OS_UNIX) && !defined(Q_OS_LINUX)
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+  // Bytes asked to the heap so far, counted where malloc can be replaced
+  std::atomic<qint64> allocatedBytes(0);
+
+} // anonymous namespace end
+
+#if defined(__GLIBC__)
+#define COUNTS_ALLOCATIONS
+
+// Every allocation of the process goes through these, Qt's and the standard library's too
+extern "C" {
+  void* __libc_malloc(size_t size);
+  void* __libc_calloc(size_t count, size_t size);
+  void* __libc_realloc(void* pointer, size_t size);
+
+  void* malloc(size_t size)
+  {
+    allocatedBytes.fetch_add(qint64(size), std::memory_order_relaxed);
+    return __libc_malloc(size);
+  }
+
+  void* calloc(size_t count, size_t size)
+  {
+    allocatedBytes.fetch_add(qint64(count * size), std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+  }
+
+  void* realloc(void* pointer, size_t size)
+  {
+    allocatedBytes.fetch_add(qint64(size), std::memory_order_relaxed);
+    return __libc_realloc(pointer, size);
+  }
+}
+#endif
+
+using namespace chrishenx;
+
+namespace {
+
+  const qint64 SIZES[] = {64, 1 << 10, 1 << 14, 1 << 18, 1 << 22, 100000000}; // In bits
+  const qint64 DEFAULT_MAX_BITS = 100000000;
+  // generate* fill a single QVector, which Qt 5 keeps under 2 GiB, so larger messages are timed
+  // through encodeRangeInto() a piece at a time
+  const qint64 MAX_GENERATE_BITS = 1 << 24;
+  const qint64 PIECE_BITS = 1 << 20;
+  const qint64 DEFAULT_MAX_PLOT_BITS = 1 << 22; // The plots take about 80 bytes per point
+  const qint64 MIN_DURATION = 200000000; // ns a case is repeated for
+  const int PLOT_WIDTH = 1280; // px
+  const int PLOT_HEIGHT = 720; // px
+
+  struct Generator
+  {
+    const char* name;
+    BinaryEncoder::Data (BinaryEncoder::*generate)();
+    BinaryEncoder::Method method;
+  };
+
+  const Generator GENERATORS[] = {
+    {"generateClock", &BinaryEncoder::generateClock, BinaryEncoder::Method::CLOCK},
+    {"generateTTL", &BinaryEncoder::generateTTL, BinaryEncoder::Method::TTL},
+    {"generateNRZL", &BinaryEncoder::generateNRZL, BinaryEncoder::Method::NRZL},
+    {"generateNRZI", &BinaryEncoder::generateNRZI, BinaryEncoder::Method::NRZI},
+    {"generateBipolar", &BinaryEncoder::generateBipolar, BinaryEncoder::Method::BIPOLAR},
+    {"generatePseudoternary", &BinaryEncoder::generatePseudoternary, BinaryEncoder::Method::PSEUDOTERNARY},
+    {"generateManchester", &BinaryEncoder::generateManchester, BinaryEncoder::Method::MANCHESTER},
+    {"generateDManchester", &BinaryEncoder::generateDManchester, BinaryEncoder::Method::DMANCHESTER}
+  };
+
+  struct Result
+  {
+    QString name;
+    qint64 bits;
+    int iterations;
+    double nsPerBit;
+    qint64 bytesAllocated; // Per iteration, -1 when they cannot be counted
+    qint64 peakRss; // In bytes, -1 when unknown
+  };
+
+  // The peak resident set size can only be reset on Linux, elsewhere it is the one of the process
+  void resetPeakRss()
+  {
+#ifdef Q_OS_LINUX
+    QFile clearRefs("/proc/self/clear_refs");
+    if (clearRefs.open(QIODevice::WriteOnly))
+    {
+      clearRefs.write("5");
+    }
+#endif
+  }
+
+  qint64 peakRss()
+  {
+#if defined(Q_OS_LINUX)
+    QFile status("/proc/self/status");
+    if (status.open(QIODevice::ReadOnly))
+    {
+      for (const QByteArray& line : status.readAll().split('\n'))
+      {
+        if (line.startsWith("VmHWM:"))
+        {
+          return line.mid(6).trimmed().split(' ').first().toLongLong() * 1024;
+        }
+      }
+    }
+    return -1;
+#elif defined(Q_OS_UNIX)
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef Q_OS_MACOS
+    return usage.ru_maxrss;
+#else
+    return qint64(usage.ru_maxrss) * 1024;
+#endif
+#else
+    return -1;
+#endif
+  }
+
+  // Runs once and then again until MIN_DURATION has passed. What run returns is destroyed out of
+  // the time measured
+  template <typename Run>
+  Result measure(const QString& name, qint64 bits, Run run)
+  {
+    resetPeakRss();
+    const qint64 allocatedBefore = allocatedBytes.load();
+    qint64 elapsed = 0;
+    int iterations = 0;
+    QElapsedTimer timer;
+    do
+    {
+      timer.start();
+      const auto result = run();
+      elapsed += timer.nsecsElapsed();
+      Q_UNUSED(result);
+      ++iterations;
+    } while (elapsed < MIN_DURATION);
+#ifdef COUNTS_ALLOCATIONS
+    const qint64 allocated = (allocatedBytes.load() - allocatedBefore) / iterations;
+#else
+    const qint64 allocated = -1;
+    Q_UNUSED(allocatedBefore);
+#endif
+    return Result {name, bits, iterations, double(elapsed) / iterations / bits, allocated, peakRss()};
+  }
+
+  BitBuffer randomBits(qint64 size, std::mt19937_64& random)
+  {
+    BitBuffer bits(size);
+    uchar* data = bits.data();
+    for (qint64 i = 0; i < (size + 7) / 8; ++i)
+    {
+      data[i] = uchar(random());
+    }
+    return bits;
+  }
+
+  QString randomHex(qint64 digits, std::mt19937_64& random)
+  {
+    static const char DIGITS[] = "0123456789abcdefABCDEF";
+    QString hex(int(digits), Qt::Uninitialized);
+    for (QChar& digit : hex)
+    {
+      digit = QLatin1Char(DIGITS[random() % (sizeof(DIGITS) - 1)]);
+    }
+    return hex;
+  }
+
+  // The whole message encoded into out a piece at a time, returning how many points were written
+  qint64 encodeInPieces(const BinaryEncoder& encoder, BinaryEncoder::Method method, BinaryEncoder::Data& out)
+  {
+    qint64 written = 0;
+    for (qint64 first = 0; first < encoder.bitCount(); first += PIECE_BITS)
+    {
+      const qint64 count = qMin(PIECE_BITS, encoder.bitCount() - first);
+      written += encoder.encodeRangeInto(method, first, count, BinaryEncoder::DEFAULT_LEVELS, out.data());
+    }
+    return written;
+  }
+
+  QJsonValue optional(qint64 value)
+  {
+    return value < 0 ? QJsonValue() : QJsonValue(double(value));
+  }
+
+} // anonymous namespace end
+
+int main(int argc, char* argv[])
+{
+  if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+  { // The plots are drawn without a display
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+  }
+  QApplication app(argc, argv);
+  QApplication::setApplicationName("binary-encoding-bench");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Times the encoders, the hexadecimal conversions and the plots.");
+  parser.addHelpOption();
+  const QCommandLineOption outputOption({"o", "output"}, "JSON results file, standard output when it is -.",
+                                        "file", "-");
+  const QCommandLineOption maxBitsOption("max-bits", "Largest message size benchmarked.", "bits",
+                                         QString::number(DEFAULT_MAX_BITS));
+  const QCommandLineOption maxPlotBitsOption("max-plot-bits", "Largest message size plotted.", "bits",
+                                             QString::number(DEFAULT_MAX_PLOT_BITS));
+  const QCommandLineOption filterOption({"f", "filter"}, "Only the cases whose name contains text.", "text");
+  parser.addOptions({outputOption, maxBitsOption, maxPlotBitsOption, filterOption});
+  parser.process(app);
+  const qint64 maxBits = parser.value(maxBitsOption).toLongLong();
+  const qint64 maxPlotBits = parser.value(maxPlotBitsOption).toLongLong();
+  const QString filter = parser.value(filterOption);
+  auto wanted = [&](const QString& name) { return name.contains(filter); };
+
+  QCustomPlot plot;
+  plot.setGeometry(0, 0, PLOT_WIDTH, PLOT_HEIGHT);
+  plot.yAxis->setRange(-BinaryEncoder::DEFAULT_AMPLITUDE * 1.08, BinaryEncoder::DEFAULT_AMPLITUDE * 1.08);
+  QCPGraph* graph = plot.addGraph();
+  plot.show();
+  app.processEvents();
+
+  QJsonArray resultArray;
+  auto report = [&](const Result& result)
+  {
+    fprintf(stderr, "%-22s %10lld bits %12.3f ns/bit %14lld B/iteration %8lld KiB peak\n",
+            qPrintable(result.name), result.bits, result.nsPerBit, result.bytesAllocated,
+            result.peakRss < 0 ? -1 : result.peakRss / 1024);
+    resultArray << QJsonObject {
+      {"name", result.name},
+      {"bits", double(result.bits)},
+      {"iterations", result.iterations},
+      {"nsPerBit", result.nsPerBit},
+      {"bytesAllocated", optional(result.bytesAllocated)},
+      {"peakRss", optional(result.peakRss)}
+    };
+  };
+
+  std::mt19937_64 random(20151017); // The same messages on every run
+  for (qint64 bits : SIZES)
+  {
+    if (bits > maxBits)
+    {
+      break;
+    }
+    BinaryEncoder encoder(randomBits(bits, random));
+    if (bits <= MAX_GENERATE_BITS)
+    {
+      for (const Generator& generator : GENERATORS)
+      {
+        if (wanted(generator.name))
+        {
+          report(measure(generator.name, bits, [&]() { return (encoder.*generator.generate)(); }));
+        }
+      }
+      if (wanted("generateMultilevel"))
+      {
+        report(measure("generateMultilevel", bits, [&]()
+        {
+          return encoder.generateMultilevel(BinaryEncoder::DEFAULT_LEVELS);
+        }));
+      }
+    }
+    else
+    {
+      encoder.buildCheckpoints(BinaryEncoder::DEFAULT_LEVELS);
+      BinaryEncoder::Data piece(int(PIECE_BITS * 4 + 1));
+      QList<QPair<QString, BinaryEncoder::Method>> methods;
+      for (const Generator& generator : GENERATORS)
+      {
+        methods << qMakePair(QString(generator.name).mid(8), generator.method);
+      }
+      methods << qMakePair(QString("Multilevel"), BinaryEncoder::Method::MULTILEVEL);
+      for (const auto& method : methods)
+      {
+        const QString name = "encodeRangeInto" + method.first;
+        if (wanted(name))
+        {
+          report(measure(name, bits, [&]() { return encodeInPieces(encoder, method.second, piece); }));
+        }
+      }
+    }
+
+    const QString hex = randomHex(bits / 4, random);
+    if (wanted("firstInvalidHexDigit"))
+    {
+      report(measure("firstInvalidHexDigit", bits, [&]() { return firstInvalidHexDigit(hex); }));
+    }
+    if (wanted("hexToBits"))
+    {
+      report(measure("hexToBits", bits, [&]() { return hexToBits(hex); }));
+    }
+    if (wanted("hexToBitString"))
+    {
+      report(measure("hexToBitString", bits, [&]() { return hexToBitString(hex); }));
+    }
+
+    if (bits <= maxPlotBits && (wanted("QCPGraph::setData") || wanted("QCustomPlot::replot")))
+    {
+      const BinaryEncoder::Data points = encoder.generateNRZL();
+      plot.xAxis->setRange(0, encoder.timeMax());
+      if (wanted("QCPGraph::setData"))
+      {
+        report(measure("QCPGraph::setData", bits, [&]()
+        {
+          graph->setData(points);
+          return 0;
+        }));
+      }
+      else
+      {
+        graph->setData(points);
+      }
+      if (wanted("QCustomPlot::replot"))
+      {
+        report(measure("QCustomPlot::replot", bits, [&]()
+        {
+          plot.replot();
+          return 0;
+        }));
+      }
+      graph->clearData();
+    }
+  }
+
+#ifdef COUNTS_ALLOCATIONS
+  const bool countsAllocations = true;
+#else
+  const bool countsAllocations = false;
+#endif
+  const QJsonObject description {
+    {"qtVersion", qVersion()},
+    {"idealThreadCount", QThread::idealThreadCount()},
+    {"countsAllocations", countsAllocations},
+    {"results", resultArray}
+  };
+  QFile output;
+  const QString fileName = parser.value(outputOption);
+  bool opened;
+  if (fileName == "-")
+  {
+    opened = output.open(stdout, QIODevice::WriteOnly);
+  }
+  else
+  {
+    output.setFileName(fileName);
+    opened = output.open(QIODevice::WriteOnly);
+  }
+  if (!opened || output.write(QJsonDocument(description).toJson()) < 0)
+  {
+    fprintf(stderr, "%s: %s\n", qPrintable(QApplication::applicationName()), qPrintable(output.errorString()));
+    return 1;
+  }
+  return 0;
+}
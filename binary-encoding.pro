@@ -4,22 +4,15 @@
 #
 #-------------------------------------------------
 
-QT       += core gui
+TEMPLATE = subdirs
 
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets printsupport
+# gui is the binary-encoding application, cli the headless binary-encoding-cli, bench the
+# binary-encoding-bench benchmarks, latency the binary-encoding-latency GUI harness and tests the
+# binary-encoding-tests unit tests, run by make check
+SUBDIRS = gui cli bench latency tests
 
-TARGET = binary-encoding
-TEMPLATE = app
-
-CONFIG += c++11
-
-SOURCES += main.cpp\
-    qcustomplot/qcustomplot.cpp \
-    binaryencoder.cpp \
-    mainwindow.cpp
-
-HEADERS  += mainwindow.h \
-    qcustomplot/qcustomplot.h \
-    binaryencoder.h
-
-FORMS    += mainwindow.ui
+gui.file = gui/gui.pro
+cli.file = cli/cli.pro
+bench.file = bench/bench.pro
+latency.file = latency/latency.pro
+tests.file = tests/tests.pro
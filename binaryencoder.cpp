@@ -23,6 +23,7 @@
   */
 
 #include "binaryencoder.h"
+#include "tracing.h"
 
 #include <QDebug>
 
@@ -31,231 +32,295 @@ using namespace chrishenx;
 
 const double BinaryEncoder::DEFAULT_TRANS_SPEED = 1;
 const double BinaryEncoder::DEFAULT_AMPLITUDE = 5;
+const int BinaryEncoder::DEFAULT_LEVELS = 2;
+const int BinaryEncoder::DEFAULT_CHECKPOINT_INTERVAL = 4096;
 
-BinaryEncoder::Data BinaryEncoder::generateClock()
+void BinaryEncoder::setBits(BitBuffer bits)
+{
+  mBits = bits;
+  mN = bits.size();
+  mCheckpoints.clear();
+}
+
+void BinaryEncoder::setCheckpointInterval(int bits)
+{
+  Q_ASSERT(bits > 0);
+  mCheckpointInterval = bits;
+  mCheckpoints.clear();
+}
+
+int BinaryEncoder::pointsPerBit(Method method)
 {
-  static const int POINTS_PER_BIT = 4;
-  const int POINT_COUNT = mN * POINTS_PER_BIT;
-  Data clock(POINT_COUNT);
-  const double f = mTransSpeed * 2; // Clock frecuency
-  const double T = 1.0 / f; // Clock period
-  double t = 0.0; // current time
-  for (int i = 0; i < POINT_COUNT; i += POINTS_PER_BIT)
+  switch (method)
   {
-    clock[i] = make_pair(t, 0.0);
-    clock[i + 1] = make_pair(t += T, 0.0);
-    clock[i + 2] = make_pair(t, mAmplitude);
-    clock[i + 3] = make_pair(t += T, mAmplitude);
+  case Method::MANCHESTER:
+  case Method::DMANCHESTER:
+  case Method::CLOCK:
+    return 4;
+  default:
+    return 2;
   }
-  mTimeMax = t;
-  return clock;
+}
+
+BinaryEncoder::Data BinaryEncoder::generateClock()
+{
+  TraceScope traceScope("BinaryEncoder::generateClock");
+  mTimeMax = mN / mTransSpeed;
+  return encodeRange(Method::CLOCK, 0, mN);
 }
 
 BinaryEncoder::Data BinaryEncoder::generateTTL()
 {
-  static const int POINTS_PER_BIT = 2;
-  const int POINT_COUNT = mN * POINTS_PER_BIT;
-  Data ttl(POINT_COUNT);
-  const double f = mTransSpeed;
-  const double T = 1.0 / f;
-  double t = 0.0;
-  for (int i = 0; i < POINT_COUNT; i += POINTS_PER_BIT)
-  {
-    const double amplitude = mValueToEncode[i / POINTS_PER_BIT].digitValue() * mAmplitude;
-    ttl[i] = make_pair(t, amplitude);
-    ttl[i + 1] = make_pair(t += T, amplitude);
-  }
-  mTimeMax = t;
-  return ttl;
+  TraceScope traceScope("BinaryEncoder::generateTTL");
+  mTimeMax = mN / mTransSpeed;
+  return encodeRange(Method::TTL, 0, mN);
 }
 
 BinaryEncoder::Data BinaryEncoder::generateNRZL()
 {
-  static const int POINTS_PER_BIT = 2;
-  const int POINT_COUNT = mN * POINTS_PER_BIT;
-  Data nrzl(POINT_COUNT);
-  const double f = mTransSpeed;
-  const double T = 1.0 / f;
-  double t = 0.0;
-  for (int i = 0; i < POINT_COUNT; i += POINTS_PER_BIT) {
-    const double amplitude = mValueToEncode[i / POINTS_PER_BIT].digitValue() ?
-          -mAmplitude : mAmplitude;
-    nrzl[i] = make_pair(t, amplitude);
-    nrzl[i + 1] = make_pair(t += T, amplitude);
-  }
-  mTimeMax = t;
-  return nrzl;
+  TraceScope traceScope("BinaryEncoder::generateNRZL");
+  mTimeMax = mN / mTransSpeed;
+  return encodeRange(Method::NRZL, 0, mN);
 }
 
 BinaryEncoder::Data BinaryEncoder::generateNRZI()
 {
-  static const int POINTS_PER_BIT = 2;
-  const int POINT_COUNT = mN * POINTS_PER_BIT;
-  Data nrzi(POINT_COUNT);
-  const double f = mTransSpeed;
-  const double T = 1.0 / f;
-  double t = 0.0;
-  double amplitude = -mAmplitude;
-  for (int i = 0; i < POINT_COUNT; i += POINTS_PER_BIT)
-  {
-    if (mValueToEncode[i / POINTS_PER_BIT].digitValue()) // Transition?
-    {
-      amplitude = amplitude == mAmplitude ? -mAmplitude : mAmplitude;
-    }
-    nrzi[i] = make_pair(t, amplitude);
-    nrzi[i + 1] = make_pair(t += T, amplitude);
-  }
-  mTimeMax = t;
-  return nrzi;
+  TraceScope traceScope("BinaryEncoder::generateNRZI");
+  mTimeMax = mN / mTransSpeed;
+  return encodeRange(Method::NRZI, 0, mN);
 }
 
 BinaryEncoder::Data BinaryEncoder::generateBipolar()
 {
-  static const int POINTS_PER_BIT = 2;
-  const int POINT_COUNT = mN * POINTS_PER_BIT;
-  Data bipolar(POINT_COUNT);
-  const double f = mTransSpeed;
-  const double T = 1.0 / f;
-  double t = 0.0;
-  double multiplier = 1;
-  for (int i = 0; i < POINT_COUNT; i += POINTS_PER_BIT)
-  {
-    const int bit = mValueToEncode[i / POINTS_PER_BIT].digitValue();
-    const double amplitude = bit ? multiplier * mAmplitude : 0;
-    bipolar[i] = make_pair(t, amplitude);
-    bipolar[i + 1] = make_pair(t += T, amplitude);
-    if (bit)
-    {
-      multiplier *= -1;
-    }
-  }
-  mTimeMax = t;
-  return bipolar;
+  TraceScope traceScope("BinaryEncoder::generateBipolar");
+  mTimeMax = mN / mTransSpeed;
+  return encodeRange(Method::BIPOLAR, 0, mN);
 }
 
 BinaryEncoder::Data BinaryEncoder::generatePseudoternary()
 {
-  static const int POINTS_PER_BIT = 2;
-  const int POINT_COUNT = mN * POINTS_PER_BIT;
-  Data pseudoternary(POINT_COUNT);
-  const double f = mTransSpeed;
-  const double T = 1.0 / f;
-  double t = 0.0;
-  double multiplier = 1;
-  for (int i = 0; i < POINT_COUNT; i += POINTS_PER_BIT)
-  {
-    const int bit = mValueToEncode[i / POINTS_PER_BIT].digitValue();
-    const double amplitude = !bit ? multiplier * mAmplitude : 0;
-    pseudoternary[i] = make_pair(t, amplitude);
-    pseudoternary[i + 1] = make_pair(t += T, amplitude);
-    if (!bit)
-    {
-      multiplier *= -1;
-    }
-  }
-  mTimeMax = t;
-  return pseudoternary;
+  TraceScope traceScope("BinaryEncoder::generatePseudoternary");
+  mTimeMax = mN / mTransSpeed;
+  return encodeRange(Method::PSEUDOTERNARY, 0, mN);
 }
 
 BinaryEncoder::Data BinaryEncoder::generateManchester()
 {
-  static const int POINTS_PER_BIT = 4;
-  const int POINT_COUNT = mN * POINTS_PER_BIT;
-  Data manchester(POINT_COUNT);
-  const double f = mTransSpeed * 2; // Clock frecuency
-  const double T = 1.0 / f; // Clock period
-  double t = 0.0; // current time
-  for (int i = 0; i < POINT_COUNT; i += POINTS_PER_BIT)
-  {
-    const int bit = mValueToEncode[i / POINTS_PER_BIT].digitValue();
-    const double amp1 = bit ? -mAmplitude : mAmplitude;
-    const double amp2 = -amp1;
-    manchester[i] = make_pair(t, amp1);
-    manchester[i + 1] = make_pair(t += T, amp1);
-    manchester[i + 2] = make_pair(t, amp2);
-    manchester[i + 3] = make_pair(t += T, amp2);
-  }
-  mTimeMax = t;
-  return manchester;
+  TraceScope traceScope("BinaryEncoder::generateManchester");
+  mTimeMax = mN / mTransSpeed;
+  return encodeRange(Method::MANCHESTER, 0, mN);
 }
 
 BinaryEncoder::Data BinaryEncoder::generateDManchester()
 {
-  static const int POINTS_PER_BIT = 4;
-  const int POINT_COUNT = mN * POINTS_PER_BIT;
-  Data manchester(POINT_COUNT);
-  const double f = mTransSpeed * 2; // Clock frecuency
-  const double T = 1.0 / f; // Clock period
-  double t = 0.0; // current time
-  double amplitude = mAmplitude;
-  for (int i = 0; i < POINT_COUNT; i += POINTS_PER_BIT)
-  {
-    manchester[i] = make_pair(t, amplitude);
-    if (mValueToEncode[i / POINTS_PER_BIT].digitValue())
-    { // Make no transition
-      manchester[i + 1] = make_pair(t += T, amplitude);
-      manchester[i + 2] = make_pair(t, amplitude *= -1);
-      manchester[i + 3] = make_pair(t += T, amplitude);
-    }
-    else
-    { // Make transition
-      manchester[i + 1] = make_pair(t, amplitude *= -1);
-      manchester[i + 2] = make_pair(t += T, amplitude);
-      manchester[i + 3] = make_pair(t, amplitude *= -1);
-      t += T;
-      if (i + 4 == POINT_COUNT) {
-        // When the input ends with zero, its necesary add one point
-        manchester << make_pair(t, amplitude);
-      }
-    }
-  }
-  mTimeMax = t;
-  return manchester;
+  TraceScope traceScope("BinaryEncoder::generateDManchester");
+  mTimeMax = mN / mTransSpeed;
+  return encodeRange(Method::DMANCHESTER, 0, mN);
 }
 
 BinaryEncoder::Data BinaryEncoder::generateMultilevel(int levels)
 {
-  static const int POINTS_PER_BIT = 2;
-  const int POINT_COUNT = mN * POINTS_PER_BIT;
-  Data multilevel(POINT_COUNT);
-  const double f = mTransSpeed; // Clock frecuency
-  const double T = 1.0 / f; // Clock period
-  double t = 0.0;
-  bool down = mValueToEncode[0].digitValue();
-  double amplitude = down ? mAmplitude : -mAmplitude;
-  const double levelIncrement = mAmplitude * 2 / (levels - 1);
-  for (int i = 0; i < POINT_COUNT; i += POINTS_PER_BIT)
+  TraceScope traceScope("BinaryEncoder::generateMultilevel");
+  mTimeMax = mN / mTransSpeed;
+  return encodeRange(Method::MULTILEVEL, 0, mN, levels);
+}
+
+BinaryEncoder::Data BinaryEncoder::encodeRange(Method method, qint64 first, qint64 count, int levels)
+{
+  TraceScope traceScope("BinaryEncoder::encodeRange");
+  first = qBound(qint64(0), first, mN);
+  count = qBound(qint64(0), count, mN - first);
+  State state = stateAt(first, levels);
+  // One extra point for the differential Manchester closing point
+  Data data(int(count * pointsPerBit(method) + 1));
+  data.resize(int(encodeInto(method, levels, state, first, count, true, data.data())));
+  return data;
+}
+
+void BinaryEncoder::buildCheckpoints(int levels)
+{
+  stateAt(mN, levels);
+}
+
+qint64 BinaryEncoder::encodeRangeInto(Method method, qint64 first, qint64 count, int levels, Point* out) const
+{
+  Q_ASSERT(!mCheckpoints.isEmpty() && (method != Method::MULTILEVEL || mCheckpointLevels == levels));
+  first = qBound(qint64(0), first, mN);
+  count = qBound(qint64(0), count, mN - first);
+  State state = checkpointState(first, levels);
+  return encodeInto(method, levels, state, first, count, first + count == mN, out);
+}
+
+BinaryEncoder::State BinaryEncoder::initialState(int levels) const
+{
+  State state;
+  state.nrziSign = -1;
+  state.bipolarSign = 1;
+  state.pseudoternarySign = 1;
+  state.dmanchesterSign = 1;
+  state.multilevelDown = mN > 0 && bit(0);
+  state.multilevelLevel = state.multilevelDown ? levels - 1 : 0;
+  return state;
+}
+
+void BinaryEncoder::advance(State& state, qint64 index, int levels) const
+{
+  if (bit(index))
   {
-    if (i != 0 && mValueToEncode[i / POINTS_PER_BIT].digitValue())
+    state.nrziSign = -state.nrziSign;
+    state.bipolarSign = -state.bipolarSign;
+    state.dmanchesterSign = -state.dmanchesterSign;
+    if (index != 0)
     {
-      //qDebug() << amplitude;
-      if (down)
+      if (state.multilevelDown)
       {
-        if (amplitude > -mAmplitude)
+        if (state.multilevelLevel > 0)
         {
-          amplitude -= levelIncrement;
+          state.multilevelLevel--;
         }
         else
         {
-          amplitude += levelIncrement; // Otherwise the effect comes on the next high level detected
-          down = false;
+          state.multilevelLevel++; // Otherwise the effect comes on the next high level detected
+          state.multilevelDown = false;
         }
       }
       else // up
       {
-        if (amplitude < mAmplitude)
+        if (state.multilevelLevel < levels - 1)
         {
-          amplitude += levelIncrement;
+          state.multilevelLevel++;
         }
         else
         {
-          amplitude -= levelIncrement; // Otherwise the effect comes on the next low level detected
-          down = true;
+          state.multilevelLevel--; // Otherwise the effect comes on the next low level detected
+          state.multilevelDown = true;
+        }
+      }
+    }
+  }
+  else
+  {
+    state.pseudoternarySign = -state.pseudoternarySign;
+  }
+}
+
+BinaryEncoder::State BinaryEncoder::stateAt(qint64 index, int levels)
+{
+  Q_ASSERT(levels >= 2);
+  if (mCheckpoints.isEmpty() || mCheckpointLevels != levels)
+  {
+    mCheckpoints.clear();
+    mCheckpoints << initialState(levels);
+    mCheckpointLevels = levels;
+  }
+  // Every checkpoint holds the state of all the methods, so any method can resume from it. They
+  // are recorded only as far as asked for, a walk from the start reads every bit about once
+  const qint64 checkpoint = index / mCheckpointInterval;
+  while (mCheckpoints.size() <= checkpoint && mCheckpoints.size() * qint64(mCheckpointInterval) < mN)
+  {
+    State state = mCheckpoints.last();
+    const qint64 from = (mCheckpoints.size() - 1) * qint64(mCheckpointInterval);
+    for (qint64 i = from; i < from + mCheckpointInterval; ++i)
+    {
+      advance(state, i, levels);
+    }
+    mCheckpoints << state;
+  }
+  return checkpointState(index, levels);
+}
+
+BinaryEncoder::State BinaryEncoder::checkpointState(qint64 index, int levels) const
+{
+  const qint64 checkpoint = qMin(index / mCheckpointInterval, qint64(mCheckpoints.size() - 1));
+  State state = mCheckpoints[int(checkpoint)];
+  for (qint64 i = checkpoint * mCheckpointInterval; i < index; ++i)
+  {
+    advance(state, i, levels);
+  }
+  return state;
+}
+
+qint64 BinaryEncoder::encodeInto(Method method, int levels, State& state, qint64 first, qint64 count,
+                                 bool closed, Point* out) const
+{
+  const double T = 1.0 / mTransSpeed; // Bit period
+  const double halfT = T / 2;
+  const double levelIncrement = mAmplitude * 2 / (levels - 1);
+  Point* point = out;
+  for (qint64 i = first; i < first + count; ++i)
+  {
+    const int bit = this->bit(i);
+    const double t = i * T;
+    const double tEnd = (i + 1) * T;
+    const State before = state;
+    advance(state, i, levels);
+    double amplitude;
+    switch (method)
+    {
+    case Method::TTL:
+      amplitude = bit * mAmplitude;
+      *point++ = make_pair(t, amplitude);
+      *point++ = make_pair(tEnd, amplitude);
+      break;
+    case Method::NRZL:
+      amplitude = bit ? -mAmplitude : mAmplitude;
+      *point++ = make_pair(t, amplitude);
+      *point++ = make_pair(tEnd, amplitude);
+      break;
+    case Method::NRZI:
+      amplitude = state.nrziSign * mAmplitude;
+      *point++ = make_pair(t, amplitude);
+      *point++ = make_pair(tEnd, amplitude);
+      break;
+    case Method::BIPOLAR:
+      amplitude = bit ? before.bipolarSign * mAmplitude : 0;
+      *point++ = make_pair(t, amplitude);
+      *point++ = make_pair(tEnd, amplitude);
+      break;
+    case Method::PSEUDOTERNARY:
+      amplitude = !bit ? before.pseudoternarySign * mAmplitude : 0;
+      *point++ = make_pair(t, amplitude);
+      *point++ = make_pair(tEnd, amplitude);
+      break;
+    case Method::MANCHESTER:
+      amplitude = bit ? -mAmplitude : mAmplitude;
+      *point++ = make_pair(t, amplitude);
+      *point++ = make_pair(t + halfT, amplitude);
+      *point++ = make_pair(t + halfT, -amplitude);
+      *point++ = make_pair(tEnd, -amplitude);
+      break;
+    case Method::DMANCHESTER:
+      amplitude = before.dmanchesterSign * mAmplitude;
+      *point++ = make_pair(t, amplitude);
+      if (bit)
+      { // Make no transition
+        *point++ = make_pair(t + halfT, amplitude);
+        *point++ = make_pair(t + halfT, -amplitude);
+        *point++ = make_pair(tEnd, -amplitude);
+      }
+      else
+      { // Make transition
+        *point++ = make_pair(t, -amplitude);
+        *point++ = make_pair(t + halfT, -amplitude);
+        *point++ = make_pair(t + halfT, amplitude);
+        if (closed && i + 1 == first + count) {
+          // When the range ends with zero, its necesary add one point
+          *point++ = make_pair(tEnd, amplitude);
         }
       }
+      break;
+    case Method::MULTILEVEL:
+      amplitude = state.multilevelLevel * levelIncrement - mAmplitude;
+      *point++ = make_pair(t, amplitude);
+      *point++ = make_pair(tEnd, amplitude);
+      break;
+    case Method::CLOCK:
+      *point++ = make_pair(t, 0.0);
+      *point++ = make_pair(t + halfT, 0.0);
+      *point++ = make_pair(t + halfT, mAmplitude);
+      *point++ = make_pair(tEnd, mAmplitude);
+      break;
     }
-    multilevel[i] = make_pair(t, amplitude);
-    multilevel[i + 1] = make_pair(t += T, amplitude);
   }
-  return multilevel;
+  return point - out;
 }
@@ -25,6 +25,8 @@
 #ifndef BINARYENCODER_H
 #define BINARYENCODER_H
 
+#include "bitbuffer.h"
+
 #include <QVector>
 #include <utility>
 
@@ -33,24 +35,43 @@ namespace chrishenx {
   class BinaryEncoder
   {
   public:
-    using Data = QVector<std::pair<double, double>>;
+    using Point = std::pair<double, double>;
+    using Data = QVector<Point>;
 
       enum class Method {
-          TTL, NRZL, NRZI, BIPOLAR, PSEUDOTERNARY, MANCHESTER, DMANCHESTER
+          TTL, NRZL, NRZI, BIPOLAR, PSEUDOTERNARY, MANCHESTER, DMANCHESTER, MULTILEVEL,
+          CLOCK // Reference clock, not an encoding
       };
 
+    // Everything a stateful method needs to resume encoding right before a given bit
+    struct State
+    {
+      int nrziSign; // Level of the previous bit, +1 or -1
+      int bipolarSign; // Polarity of the next mark
+      int pseudoternarySign; // Polarity of the next space
+      int dmanchesterSign; // Level at the end of the previous bit
+      int multilevelLevel; // Level index, 0 is -amplitude
+      bool multilevelDown;
+    };
+
     static const double DEFAULT_TRANS_SPEED; // In seconds
     static const double DEFAULT_AMPLITUDE; // In volts
+    static const int DEFAULT_LEVELS;
+    static const int DEFAULT_CHECKPOINT_INTERVAL; // In bits
 
     BinaryEncoder(QString valueToEncode)
-      : BinaryEncoder(valueToEncode, DEFAULT_TRANS_SPEED) {}
+      : BinaryEncoder(BitBuffer::fromBitString(valueToEncode)) {}
 
     BinaryEncoder(QString valueToEncode, double transSpeed)
       : BinaryEncoder(valueToEncode, transSpeed, DEFAULT_AMPLITUDE) {}
 
     BinaryEncoder(QString valueToEncode, double transSpeed, double amplitude)
-        : mValueToEncode(valueToEncode), mTransSpeed(transSpeed),mAmplitude(amplitude) {
-      mN = valueToEncode.length();
+      : BinaryEncoder(BitBuffer::fromBitString(valueToEncode), transSpeed, amplitude) {}
+
+    BinaryEncoder(BitBuffer bits, double transSpeed = DEFAULT_TRANS_SPEED,
+                  double amplitude = DEFAULT_AMPLITUDE)
+        : mBits(bits), mTransSpeed(transSpeed),mAmplitude(amplitude) {
+      mN = bits.size();
     }
 
     double currentPeriod() const  { return 1.0 / mTransSpeed; }
@@ -61,10 +82,19 @@ namespace chrishenx {
     double amplitude() const { return mAmplitude; }
     void setAmplitude(double amplitude) { mAmplitude = amplitude; }
 
-    QString valueToEncode() const { return mValueToEncode; }
-    void setValueToEncode(QString valueToEncode) { mValueToEncode = valueToEncode; }
+    QString valueToEncode() const { return mBits.toBitString(); }
+    void setValueToEncode(QString valueToEncode) { setBits(BitBuffer::fromBitString(valueToEncode)); }
+
+    const BitBuffer& bits() const { return mBits; }
+    void setBits(BitBuffer bits);
 
-    int messageLength() const { return mValueToEncode.length(); }
+    int messageLength() const { return int(mN); }
+    qint64 bitCount() const { return mN; }
+
+    int checkpointInterval() const { return mCheckpointInterval; }
+    void setCheckpointInterval(int bits);
+
+    static int pointsPerBit(Method method);
 
     // Main methods
     Data generateClock();
@@ -77,14 +107,39 @@ namespace chrishenx {
     Data generateDManchester();
     Data generateMultilevel(int levels);
 
+    // Encodes bits [first, first + count) resuming from the nearest checkpoint, so the cost
+    // depends on the window and not on where it lies within the message
+    Data encodeRange(Method method, qint64 first, qint64 count, int levels = DEFAULT_LEVELS);
+
+    // Records every checkpoint for levels in one pass, afterwards encodeRangeInto() can be called
+    // with those levels from several threads at once
+    void buildCheckpoints(int levels = DEFAULT_LEVELS);
+    // Like encodeRange() but into out, which needs room for count * pointsPerBit(method) + 1
+    // points, returning how many were written. The differential Manchester closing point is only
+    // added at the end of the message, so the ranges of a message can be written side by side
+    qint64 encodeRangeInto(Method method, qint64 first, qint64 count, int levels, Point* out) const;
+
     double timeMax() const { return mTimeMax; }
 
   private:
-    QString mValueToEncode;
+    BitBuffer mBits;
     double mTransSpeed; // Transmission speed
     double mAmplitude; // Represent volts
     double mTimeMax = 0;
-    int mN;
+    qint64 mN;
+
+    QVector<State> mCheckpoints; // State before bits 0, N, 2N...
+    int mCheckpointInterval = DEFAULT_CHECKPOINT_INTERVAL;
+    int mCheckpointLevels = 0; // Multilevel levels the checkpoints were built for
+
+    int bit(qint64 index) const { return mBits.bit(index); }
+    State initialState(int levels) const;
+    void advance(State& state, qint64 index, int levels) const;
+    State stateAt(qint64 index, int levels);
+    State checkpointState(qint64 index, int levels) const; // From the checkpoints recorded so far
+    // closed adds the differential Manchester closing point when the range ends with a zero
+    qint64 encodeInto(Method method, int levels, State& state, qint64 first, qint64 count,
+                      bool closed, Point* out) const;
   };
 
 } // chrishenx namespace end
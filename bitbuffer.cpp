@@ -0,0 +1,196 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2015 Christian González León
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+  */
+
+#include "bitbuffer.h"
+
+#include <QtEndian>
+
+#include <cstring>
+
+using namespace chrishenx;
+
+const qint64 BitBuffer::MAX_SIZE;
+
+// Copies count bits between non overlapping buffers, a byte at a time once dst is aligned
+static void copyBits(uchar* dst, qint64 dstPos, const uchar* src, qint64 srcPos, qint64 count)
+{
+  while (count > 0 && dstPos % 8)
+  {
+    const int bit = (src[srcPos >> 3] >> (7 - (srcPos & 7))) & 1;
+    const uchar mask = uchar(0x80 >> (dstPos & 7));
+    dst[dstPos >> 3] = bit ? uchar(dst[dstPos >> 3] | mask) : uchar(dst[dstPos >> 3] & ~mask);
+    dstPos++;
+    srcPos++;
+    count--;
+  }
+  const int shift = int(srcPos & 7);
+  if (shift == 0)
+  {
+    memcpy(dst + (dstPos >> 3), src + (srcPos >> 3), size_t(count / 8));
+  }
+  else
+  {
+    const uchar* in = src + (srcPos >> 3);
+    uchar* out = dst + (dstPos >> 3);
+    for (qint64 i = 0; i < count / 8; ++i)
+    {
+      out[i] = uchar(in[i] << shift | in[i + 1] >> (8 - shift));
+    }
+  }
+  const qint64 whole = count / 8 * 8;
+  dstPos += whole;
+  srcPos += whole;
+  for (count -= whole; count > 0; --count, ++dstPos, ++srcPos)
+  {
+    const int bit = (src[srcPos >> 3] >> (7 - (srcPos & 7))) & 1;
+    const uchar mask = uchar(0x80 >> (dstPos & 7));
+    dst[dstPos >> 3] = bit ? uchar(dst[dstPos >> 3] | mask) : uchar(dst[dstPos >> 3] & ~mask);
+  }
+}
+
+BitBuffer BitBuffer::fromBitString(const QString& bits)
+{
+  BitBuffer buffer(bits.length());
+  const QChar* bit = bits.constData();
+  for (int i = 0; i < bits.length(); ++i)
+  {
+    if (bit[i] == QLatin1Char('1'))
+    {
+      buffer.setBit(i, 1);
+    }
+  }
+  return buffer;
+}
+
+BitBuffer BitBuffer::fromBitString(const char* bits, qint64 length)
+{
+  BitBuffer buffer(length);
+  uchar* out = buffer.data();
+  qint64 i = 0;
+  for (; i + 8 <= length; i += 8)
+  {
+    // The low bit of each digit moved to its place, the first digit ending up as the high bit
+    const quint64 digits = qFromLittleEndian<quint64>(reinterpret_cast<const uchar*>(bits + i))
+                           & Q_UINT64_C(0x0101010101010101);
+    out[i / 8] = uchar((digits * Q_UINT64_C(0x8040201008040201)) >> 56);
+  }
+  for (; i < length; ++i)
+  {
+    if (bits[i] == '1')
+    {
+      out[i >> 3] = uchar(out[i >> 3] | 0x80 >> (i & 7));
+    }
+  }
+  return buffer;
+}
+
+BitBuffer BitBuffer::fromBytes(const QByteArray& bytes)
+{
+  BitBuffer buffer;
+  buffer.mBytes = bytes;
+  buffer.mSize = qint64(bytes.size()) * 8;
+  return buffer;
+}
+
+BitBuffer BitBuffer::fromRawData(const uchar* data, qint64 size)
+{
+  BitBuffer buffer;
+  buffer.mRawData = data;
+  buffer.mSize = size;
+  return buffer;
+}
+
+void BitBuffer::copyRawData()
+{
+  mBytes = QByteArray(reinterpret_cast<const char*>(mRawData), int((mSize + 7) / 8));
+  mRawData = nullptr;
+  resize(mSize); // Clearing the bits past the end
+}
+
+QByteArray BitBuffer::bytes() const
+{
+  return mRawData ? QByteArray::fromRawData(reinterpret_cast<const char*>(mRawData), int((mSize + 7) / 8))
+                  : mBytes;
+}
+
+QString BitBuffer::toBitString() const
+{
+  QString bits(int(mSize), QLatin1Char('0'));
+  QChar* bit = bits.data();
+  for (qint64 i = 0; i < mSize; ++i)
+  {
+    if (this->bit(i))
+    {
+      bit[i] = QLatin1Char('1');
+    }
+  }
+  return bits;
+}
+
+void BitBuffer::resize(qint64 size)
+{
+  Q_ASSERT(size >= 0 && size <= MAX_SIZE);
+  detach();
+  const int oldBytes = mBytes.size();
+  mBytes.resize(int((size + 7) / 8));
+  if (mBytes.size() > oldBytes)
+  {
+    memset(mBytes.data() + oldBytes, 0, mBytes.size() - oldBytes);
+  }
+  // Bits past the end are kept cleared so whole bytes can be compared and written out
+  if (size % 8)
+  {
+    mBytes.data()[size / 8] &= char(0xFF << (8 - size % 8));
+  }
+  mSize = size;
+}
+
+void BitBuffer::setBit(qint64 index, int value)
+{
+  detach();
+  const uchar mask = uchar(0x80 >> (index & 7));
+  char& byte = mBytes.data()[index >> 3];
+  byte = value ? char(byte | mask) : char(byte & ~mask);
+}
+
+BitBuffer BitBuffer::mid(qint64 position, qint64 count) const
+{
+  BitBuffer bits(count);
+  copyBits(bits.data(), 0, constData(), position, count);
+  return bits;
+}
+
+void BitBuffer::replace(qint64 position, qint64 count, const BitBuffer& bits)
+{
+  const qint64 tailPosition = position + count;
+  if (bits.size() == count)
+  {
+    copyBits(data(), position, bits.constData(), 0, count);
+    return;
+  }
+  const BitBuffer tail = mid(tailPosition, mSize - tailPosition);
+  resize(position + bits.size() + tail.size());
+  copyBits(data(), position, bits.constData(), 0, bits.size());
+  copyBits(data(), position + bits.size(), tail.constData(), 0, tail.size());
+}
@@ -0,0 +1,84 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2015 Christian González León
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+  */
+
+#ifndef BITBUFFER_H
+#define BITBUFFER_H
+
+#include <QByteArray>
+#include <QString>
+
+namespace chrishenx {
+
+  // Message bits packed eight per byte, most significant bit first
+  class BitBuffer
+  {
+  public:
+    // In bits, the packed bytes have to fit in a QByteArray
+    static const qint64 MAX_SIZE = qint64(0x7FFFFFFF - 32) * 8;
+
+    BitBuffer() {}
+    explicit BitBuffer(qint64 size) { resize(size); }
+
+    static BitBuffer fromBitString(const QString& bits);
+    static BitBuffer fromBitString(const char* bits, qint64 length); // ASCII '0' and '1' digits
+    static BitBuffer fromBytes(const QByteArray& bytes); // Every bit of every byte
+    // Refers to size bits owned by someone else, like a mapped file, without copying them. They
+    // must outlive the buffer and its copies, the first change makes a copy of its own
+    static BitBuffer fromRawData(const uchar* data, qint64 size);
+    QString toBitString() const;
+
+    qint64 size() const { return mSize; }
+    bool isEmpty() const { return mSize == 0; }
+    void resize(qint64 size);
+
+    int bit(qint64 index) const
+    {
+      return (constData()[index >> 3] >> (7 - (index & 7))) & 1;
+    }
+    void setBit(qint64 index, int value);
+
+    BitBuffer mid(qint64 position, qint64 count) const;
+    // Replaces count bits from position with bits, only the bits from position on are moved
+    void replace(qint64 position, qint64 count, const BitBuffer& bits);
+
+    const uchar* constData() const
+    {
+      return mRawData ? mRawData : reinterpret_cast<const uchar*>(mBytes.constData());
+    }
+    uchar* data() { detach(); return reinterpret_cast<uchar*>(mBytes.data()); }
+    QByteArray bytes() const;
+
+  private:
+    QByteArray mBytes;
+    const uchar* mRawData = nullptr; // Used instead of mBytes when set
+    qint64 mSize = 0; // In bits
+
+    void detach() { if (mRawData) copyRawData(); }
+    void copyRawData();
+  };
+
+} // chrishenx namespace end
+
+
+#endif // BITBUFFER_H
@@ -0,0 +1,75 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2015 Christian González León
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+  */
+
+#include "bitticker.h"
+
+#include "qcustomplot/qcustomplot.h"
+
+#include <cmath>
+
+using namespace chrishenx;
+
+const int BitTicker::DEFAULT_TICK_SPACING = 60;
+
+BitTicker::BitTicker(QCPAxis* axis)
+  : QObject(axis), mAxis(axis)
+{
+  mAxis->setAutoTicks(false);
+  mAxis->setAutoTickLabels(false);
+  mAxis->setAutoSubTicks(false);
+  mAxis->parentPlot()->setPlottingHint(QCP::phCacheLabels); // Labels come back as the view pans
+  connect(mAxis, SIGNAL(ticksRequest()), this, SLOT(updateTicks()));
+}
+
+void BitTicker::updateTicks()
+{
+  const QCPRange range = mAxis->range();
+  const double visibleBits = range.size() / mBitPeriod;
+  const double maxTicks = qMax(1, mAxis->axisRect()->width() / mTickSpacing);
+  qint64 group = 1; // Bits per tick
+  while (visibleBits / group > maxTicks)
+  {
+    group *= 2;
+  }
+  const double step = group * mBitPeriod;
+  qint64 first = qMax(qint64(0), qint64(std::floor(range.lower / step)));
+  qint64 last = qint64(std::ceil(range.upper / step));
+  if (mBitCount > 0)
+  {
+    last = qMin(last, (mBitCount + group - 1) / group);
+  }
+  QVector<double> ticks;
+  QVector<QString> labels;
+  ticks.reserve(int(qMax(qint64(0), last - first + 1)));
+  labels.reserve(ticks.capacity());
+  for (qint64 k = first; k <= last; ++k)
+  {
+    ticks << k * step;
+    labels << QString::number(k * group);
+  }
+  mAxis->setTickVector(ticks);
+  mAxis->setTickVectorLabels(labels);
+  // Sub ticks keep marking bit boundaries while groups are small enough
+  mAxis->setSubTickCount(group >= 4 ? 3 : int(group - 1));
+}
@@ -0,0 +1,68 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2015 Christian González León
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+  */
+
+#ifndef BITTICKER_H
+#define BITTICKER_H
+
+#include <QObject>
+
+class QCPAxis;
+
+namespace chrishenx {
+
+  // Places the ticks of a horizontal time axis on bit boundaries. Bits are grouped in powers of two
+  // so that only the ticks of the visible range exist, with at least tickSpacing() pixels between
+  // them, whatever the message length.
+  class BitTicker : public QObject
+  {
+    Q_OBJECT
+
+  public:
+    static const int DEFAULT_TICK_SPACING; // In pixels
+
+    explicit BitTicker(QCPAxis* axis);
+
+    double bitPeriod() const { return mBitPeriod; }
+    void setBitPeriod(double bitPeriod) { mBitPeriod = bitPeriod; }
+
+    qint64 bitCount() const { return mBitCount; }
+    void setBitCount(qint64 bitCount) { mBitCount = bitCount; }
+
+    int tickSpacing() const { return mTickSpacing; }
+    void setTickSpacing(int pixels) { mTickSpacing = pixels; }
+
+  private slots:
+    void updateTicks();
+
+  private:
+    QCPAxis* mAxis;
+    double mBitPeriod = 1; // In seconds
+    qint64 mBitCount = 0;
+    int mTickSpacing = DEFAULT_TICK_SPACING;
+  };
+
+} // chrishenx namespace end
+
+
+#endif // BITTICKER_H
@@ -0,0 +1,386 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2015 Christian González León
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+  */
+
+#include "bitviewer.h"
+
+#include "bitbuffer.h"
+
+#include <QApplication>
+#include <QClipboard>
+#include <QContextMenuEvent>
+#include <QInputDialog>
+#include <QMenu>
+#include <QPainter>
+#include <QScrollBar>
+#include <QToolTip>
+
+#include <climits>
+
+using namespace chrishenx;
+
+BitViewer::BitViewer(QWidget* parent)
+  : QAbstractScrollArea(parent)
+{
+  setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+  setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+  setFocusPolicy(Qt::StrongFocus);
+  viewport()->setCursor(Qt::IBeamCursor);
+}
+
+void BitViewer::setBitBuffer(const BitBuffer* bits)
+{
+  mBits = bits;
+  mAnchor = mCursor = -1;
+  horizontalScrollBar()->setValue(0);
+  bitsChanged();
+}
+
+void BitViewer::setGroupSize(int bits)
+{
+  Q_ASSERT(bits > 0);
+  mGroupSize = bits;
+  bitsChanged();
+}
+
+qint64 BitViewer::selectionStart() const
+{
+  return mAnchor == -1 ? -1 : qMin(mAnchor, mCursor);
+}
+
+qint64 BitViewer::selectionLength() const
+{
+  return mAnchor == -1 ? 0 : qAbs(mCursor - mAnchor) + 1;
+}
+
+QString BitViewer::selectedBits() const
+{
+  const qint64 start = selectionStart();
+  QString bits(int(selectionLength()), QLatin1Char('0'));
+  for (int i = 0; i < bits.length(); ++i)
+  {
+    if (mBits->bit(start + i))
+    {
+      bits[i] = QLatin1Char('1');
+    }
+  }
+  return bits;
+}
+
+QSize BitViewer::sizeHint() const
+{
+  return QSize(groupWidth() * 8, minimumSizeHint().height());
+}
+
+QSize BitViewer::minimumSizeHint() const
+{
+  return QSize(groupWidth(), fontMetrics().height() + 2 * frameWidth() + 6);
+}
+
+void BitViewer::bitsChanged(qint64 position)
+{
+  // Whichever end of the selection the bits were removed under, it is kept within them
+  if (bitCount() == 0)
+  {
+    mAnchor = mCursor = -1;
+  }
+  else if (mAnchor != -1)
+  {
+    mAnchor = qMin(mAnchor, bitCount() - 1);
+    mCursor = qMin(mCursor, bitCount() - 1);
+  }
+  updateScrollBar();
+  const qint64 lastVisibleBit = (horizontalScrollBar()->value() + qint64(visibleGroups()) + 1) * mGroupSize;
+  if (position <= lastVisibleBit)
+  {
+    viewport()->update();
+  }
+}
+
+void BitViewer::jumpTo(qint64 bit)
+{
+  if (bitCount() == 0)
+  {
+    return;
+  }
+  bit = qBound(qint64(0), bit, bitCount() - 1);
+  horizontalScrollBar()->setValue(int(bit / mGroupSize - visibleGroups() / 2));
+  mAnchor = mCursor = bit;
+  viewport()->update();
+}
+
+void BitViewer::promptJump()
+{
+  bool accepted = false;
+  const QString text = QInputDialog::getText(this, "Ir al bit",
+                                             QString("Bit (0 - %1):").arg(qMax(bitCount() - 1, qint64(0))),
+                                             QLineEdit::Normal, QString(), &accepted);
+  bool ok = false;
+  const qint64 bit = text.toLongLong(&ok);
+  if (accepted && ok)
+  {
+    jumpTo(bit);
+  }
+}
+
+void BitViewer::selectAll()
+{
+  if (bitCount() > 0)
+  {
+    mAnchor = 0;
+    mCursor = bitCount() - 1;
+    viewport()->update();
+  }
+}
+
+void BitViewer::copy()
+{
+  if (selectionLength() > 0)
+  {
+    QApplication::clipboard()->setText(selectedBits());
+  }
+}
+
+void BitViewer::paintEvent(QPaintEvent* event)
+{
+  Q_UNUSED(event);
+  QPainter painter(viewport());
+  const QFontMetrics metrics = fontMetrics();
+  const int cell = cellWidth();
+  const int height = viewport()->height();
+  const int baseline = (height + metrics.ascent() - metrics.descent()) / 2;
+  const int zeroOffset = (cell - metrics.horizontalAdvance(QLatin1Char('0'))) / 2;
+  const int oneOffset = (cell - metrics.horizontalAdvance(QLatin1Char('1'))) / 2;
+  const qint64 first = selectionStart();
+  const qint64 last = first + selectionLength() - 1;
+  const QPen textPen = palette().color(QPalette::Text);
+  const QPen selectedPen = palette().color(QPalette::HighlightedText);
+  painter.setPen(textPen);
+
+  // Only the groups in sight are visited
+  const qint64 count = bitCount();
+  int x = contentOffset();
+  for (qint64 group = horizontalScrollBar()->value(); group < groupCount() && x < viewport()->width(); ++group)
+  {
+    for (int k = 0; k < mGroupSize; ++k, x += cell)
+    {
+      const qint64 bit = group * mGroupSize + k;
+      if (bit >= count)
+      {
+        break;
+      }
+      const bool selected = bit >= first && bit <= last;
+      if (selected)
+      {
+        painter.fillRect(x, 0, cell, height, palette().brush(QPalette::Highlight));
+        painter.setPen(selectedPen);
+      }
+      if (mBits->bit(bit))
+      {
+        painter.drawText(x + oneOffset, baseline, QString(QLatin1Char('1')));
+      }
+      else
+      {
+        painter.drawText(x + zeroOffset, baseline, QString(QLatin1Char('0')));
+      }
+      if (selected)
+      {
+        painter.setPen(textPen);
+      }
+    }
+    x += GROUP_SPACING;
+  }
+}
+
+void BitViewer::scrollContentsBy(int dx, int dy)
+{
+  Q_UNUSED(dx);
+  Q_UNUSED(dy);
+  viewport()->update(); // Scrolling is by whole groups, the visible ones are just painted again
+}
+
+void BitViewer::resizeEvent(QResizeEvent* event)
+{
+  QAbstractScrollArea::resizeEvent(event);
+  updateScrollBar();
+}
+
+void BitViewer::mousePressEvent(QMouseEvent* event)
+{
+  if (event->button() == Qt::LeftButton)
+  {
+    const qint64 bit = bitAt(event->pos().x());
+    mCursor = bit;
+    if (!(event->modifiers() & Qt::ShiftModifier) || mAnchor == -1)
+    {
+      mAnchor = bit;
+    }
+    if (bit == -1)
+    {
+      mAnchor = -1;
+    }
+    viewport()->update();
+  }
+  QAbstractScrollArea::mousePressEvent(event);
+}
+
+void BitViewer::mouseMoveEvent(QMouseEvent* event)
+{
+  if ((event->buttons() & Qt::LeftButton) && mAnchor != -1)
+  {
+    // Dragging past the edges scrolls a group at a time
+    if (event->pos().x() < 0)
+    {
+      horizontalScrollBar()->setValue(horizontalScrollBar()->value() - 1);
+    }
+    else if (event->pos().x() >= viewport()->width())
+    {
+      horizontalScrollBar()->setValue(horizontalScrollBar()->value() + 1);
+    }
+    const qint64 bit = bitAt(qBound(0, event->pos().x(), viewport()->width() - 1));
+    if (bit != -1)
+    {
+      mCursor = bit;
+    }
+    viewport()->update();
+  }
+  QAbstractScrollArea::mouseMoveEvent(event);
+}
+
+void BitViewer::keyPressEvent(QKeyEvent* event)
+{
+  QScrollBar* scrollBar = horizontalScrollBar();
+  if (event->matches(QKeySequence::Copy))
+  {
+    copy();
+  }
+  else if (event->matches(QKeySequence::SelectAll))
+  {
+    selectAll();
+  }
+  else if (event->matches(QKeySequence::Find) || (event->key() == Qt::Key_G && event->modifiers() & Qt::ControlModifier))
+  {
+    promptJump();
+  }
+  else if (event->key() == Qt::Key_Home)
+  {
+    scrollBar->setValue(scrollBar->minimum());
+  }
+  else if (event->key() == Qt::Key_End)
+  {
+    scrollBar->setValue(scrollBar->maximum());
+  }
+  else
+  {
+    QAbstractScrollArea::keyPressEvent(event);
+  }
+}
+
+void BitViewer::contextMenuEvent(QContextMenuEvent* event)
+{
+  QMenu menu(this);
+  menu.addAction("Copiar", this, SLOT(copy()))->setEnabled(selectionLength() > 0);
+  menu.addAction("Seleccionar todo", this, SLOT(selectAll()))->setEnabled(bitCount() > 0);
+  menu.addAction("Ir al bit...", this, SLOT(promptJump()))->setEnabled(bitCount() > 0);
+  menu.exec(event->globalPos());
+}
+
+bool BitViewer::viewportEvent(QEvent* event)
+{
+  if (event->type() == QEvent::ToolTip)
+  {
+    QHelpEvent* helpEvent = static_cast<QHelpEvent*>(event);
+    const qint64 bit = bitAt(helpEvent->pos().x());
+    if (bit == -1)
+    {
+      QToolTip::hideText();
+    }
+    else if (selectionLength() > 1)
+    {
+      QToolTip::showText(helpEvent->globalPos(), QString("Bit %1, %2 bits seleccionados")
+                         .arg(bit).arg(selectionLength()), viewport());
+    }
+    else
+    {
+      QToolTip::showText(helpEvent->globalPos(), QString("Bit %1").arg(bit), viewport());
+    }
+    return true;
+  }
+  return QAbstractScrollArea::viewportEvent(event);
+}
+
+qint64 BitViewer::bitCount() const
+{
+  return mBits ? mBits->size() : 0;
+}
+
+qint64 BitViewer::groupCount() const
+{
+  return (bitCount() + mGroupSize - 1) / mGroupSize;
+}
+
+int BitViewer::cellWidth() const
+{
+  const QFontMetrics metrics = fontMetrics();
+  return qMax(metrics.horizontalAdvance(QLatin1Char('0')), metrics.horizontalAdvance(QLatin1Char('1'))) +
+         BIT_SPACING;
+}
+
+int BitViewer::groupWidth() const
+{
+  return mGroupSize * cellWidth() + GROUP_SPACING;
+}
+
+int BitViewer::visibleGroups() const
+{
+  return qMax(1, viewport()->width() / groupWidth());
+}
+
+int BitViewer::contentOffset() const
+{
+  // Centered while everything fits, like the line edit it replaces
+  const qint64 contentWidth = groupCount() * groupWidth() - GROUP_SPACING;
+  return contentWidth < viewport()->width() ? int(viewport()->width() - contentWidth) / 2 : 0;
+}
+
+qint64 BitViewer::bitAt(int x) const
+{
+  x -= contentOffset();
+  if (x < 0 || bitCount() == 0)
+  {
+    return -1;
+  }
+  const qint64 group = horizontalScrollBar()->value() + x / groupWidth();
+  const int k = qMin((x % groupWidth()) / cellWidth(), mGroupSize - 1);
+  const qint64 bit = group * mGroupSize + k;
+  return bit < bitCount() ? bit : -1;
+}
+
+void BitViewer::updateScrollBar()
+{
+  QScrollBar* scrollBar = horizontalScrollBar();
+  const qint64 hiddenGroups = groupCount() - (viewport()->width() + GROUP_SPACING) / groupWidth();
+  scrollBar->setRange(0, int(qBound(qint64(0), hiddenGroups, qint64(INT_MAX))));
+  scrollBar->setPageStep(visibleGroups());
+  scrollBar->setSingleStep(1);
+}
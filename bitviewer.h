@@ -0,0 +1,98 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2015 Christian González León
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+  */
+
+#ifndef BITVIEWER_H
+#define BITVIEWER_H
+
+#include <QAbstractScrollArea>
+
+namespace chrishenx {
+
+  class BitBuffer;
+
+  // Single line view of a BitBuffer that only lays out and paints the bits in sight, so its cost
+  // does not depend on the message length. Bits are shown in groups of groupSize() and can be
+  // selected with the mouse, copied and jumped to.
+  class BitViewer : public QAbstractScrollArea
+  {
+    Q_OBJECT
+
+  public:
+    static const int DEFAULT_GROUP_SIZE = 4; // A nibble
+
+    explicit BitViewer(QWidget* parent = 0);
+
+    // The buffer is not copied, it must outlive the viewer or be replaced with setBitBuffer(0)
+    void setBitBuffer(const BitBuffer* bits);
+
+    int groupSize() const { return mGroupSize; }
+    void setGroupSize(int bits);
+
+    qint64 selectionStart() const;
+    qint64 selectionLength() const;
+    QString selectedBits() const;
+
+    QSize sizeHint() const override;
+    QSize minimumSizeHint() const override;
+
+  public slots:
+    void bitsChanged(qint64 position = 0); // Bits from position on were modified
+    void jumpTo(qint64 bit);
+    void promptJump();
+    void selectAll();
+    void copy();
+
+  protected:
+    void paintEvent(QPaintEvent* event) override;
+    void scrollContentsBy(int dx, int dy) override;
+    void resizeEvent(QResizeEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseMoveEvent(QMouseEvent* event) override;
+    void keyPressEvent(QKeyEvent* event) override;
+    void contextMenuEvent(QContextMenuEvent* event) override;
+    bool viewportEvent(QEvent* event) override;
+
+  private:
+    static const int BIT_SPACING = 4; // px
+    static const int GROUP_SPACING = 10; // px
+
+    const BitBuffer* mBits = nullptr;
+    int mGroupSize = DEFAULT_GROUP_SIZE;
+    qint64 mAnchor = -1; // Selection ends, -1 when nothing is selected
+    qint64 mCursor = -1;
+
+    qint64 bitCount() const;
+    qint64 groupCount() const;
+    int cellWidth() const;
+    int groupWidth() const;
+    int visibleGroups() const;
+    int contentOffset() const;
+    qint64 bitAt(int x) const;
+    void updateScrollBar();
+  };
+
+} // chrishenx namespace end
+
+
+#endif // BITVIEWER_H
@@ -0,0 +1,273 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2015 Christian González León
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+  */
+
+#include "capturefile.h"
+#include "mappedfile.h"
+
+#include <QtConcurrent>
+#include <QtEndian>
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <limits>
+
+using namespace chrishenx;
+
+namespace {
+
+  // The plots count their points with an int, and an out of order capture is sorted in a single
+  // vector, which Qt keeps under 2 GiB
+  const qint64 MAX_POINTS = std::numeric_limits<int>::max();
+  const qint64 MAX_SORTED_POINTS = (std::numeric_limits<int>::max() - 64) / qint64(sizeof(BinaryEncoder::Point));
+
+  struct TextChunk
+  {
+    const char* begin;
+    const char* end;
+    BinaryEncoder::Data points;
+  };
+
+  struct SampleChunk
+  {
+    qint64 start; // Index of the first sample
+    BinaryEncoder::Data points;
+  };
+
+  bool isSeparator(char c)
+  {
+    return c == ' ' || c == '\t' || c == ',' || c == ';' || c == '\r' || c == '"' || c == '+';
+  }
+
+  const char* skipSeparators(const char* p, const char* end)
+  {
+    while (p < end && isSeparator(*p))
+    {
+      ++p;
+    }
+    return p;
+  }
+
+  // Appends a point for every line of [begin, end) that starts with two numbers
+  void parseLines(const char* begin, const char* end, BinaryEncoder::Data& points)
+  {
+    const char* line = begin;
+    while (line < end)
+    {
+      const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', size_t(end - line)));
+      lineEnd = lineEnd ? lineEnd : end;
+      double time, level;
+      const std::from_chars_result parsedTime = std::from_chars(skipSeparators(line, lineEnd), lineEnd, time);
+      if (parsedTime.ec == std::errc())
+      {
+        const char* levelStart = skipSeparators(parsedTime.ptr, lineEnd);
+        if (levelStart > parsedTime.ptr &&
+            std::from_chars(levelStart, lineEnd, level).ec == std::errc())
+        {
+          points << BinaryEncoder::Point(time, level);
+        }
+      }
+      line = lineEnd + 1;
+    }
+  }
+
+  // The first line that starts at offset or after it
+  qint64 lineStart(const char* text, qint64 size, qint64 offset)
+  {
+    if (offset <= 0 || offset >= size)
+    {
+      return qBound(qint64(0), offset, size);
+    }
+    const void* newLine = std::memchr(text + offset - 1, '\n', size_t(size - offset + 1));
+    return newLine ? static_cast<const char*>(newLine) - text + 1 : size;
+  }
+
+  int sampleSize(CaptureReader::Format format)
+  {
+    switch (format)
+    {
+    case CaptureReader::Format::INT8:
+      return 1;
+    case CaptureReader::Format::INT16:
+      return 2;
+    default:
+      return 4;
+    }
+  }
+
+} // anonymous namespace end
+
+CaptureReader::CaptureReader(const QString& fileName, Format format, double sampleRate,
+                             double voltsPerUnit)
+  : mFileName(fileName), mFormat(format), mSampleRate(sampleRate), mVoltsPerUnit(voltsPerUnit)
+{
+}
+
+bool CaptureReader::read()
+{
+  mChunks.clear();
+  mError.clear();
+  MappedFile file(mFileName);
+  if (!file.map(MappedFile::Access::SEQUENTIAL))
+  {
+    mError = file.errorString();
+    return false;
+  }
+  if (mFormat == Format::TEXT)
+  {
+    readText(reinterpret_cast<const char*>(file.data()), file.size());
+  }
+  else
+  {
+    readSamples(file.data(), file.size());
+  }
+  if (!mError.isEmpty())
+  {
+    mChunks.clear();
+    return false;
+  }
+  if (mChunks.isEmpty())
+  {
+    mError = "The file has no samples";
+    return false;
+  }
+  return true;
+}
+
+QVector<BinaryEncoder::Data> CaptureReader::takeChunks()
+{
+  QVector<BinaryEncoder::Data> chunks;
+  chunks.swap(mChunks);
+  return chunks;
+}
+
+void CaptureReader::readText(const char* text, qint64 size)
+{
+  QVector<TextChunk> chunks;
+  for (qint64 offset = 0; offset < size; offset += CHUNK_SIZE)
+  {
+    const qint64 begin = lineStart(text, size, offset);
+    const qint64 end = lineStart(text, size, offset + CHUNK_SIZE);
+    if (begin < end)
+    { // Otherwise a line longer than a chunk started before it
+      chunks << TextChunk {text + begin, text + end, BinaryEncoder::Data()};
+    }
+  }
+  QtConcurrent::blockingMap(chunks, [](TextChunk& chunk)
+  {
+    chunk.points.reserve(int((chunk.end - chunk.begin) / 16)); // About the shortest of rows
+    parseLines(chunk.begin, chunk.end, chunk.points);
+  });
+  // Captures are in time order but nothing checks that they are, the plots need them to be. The
+  // chunks are kept apart unless they have to be merged to be sorted
+  const auto earlier = [](const BinaryEncoder::Point& a, const BinaryEncoder::Point& b)
+  {
+    return a.first < b.first;
+  };
+  bool sorted = true;
+  qint64 pointCount = 0;
+  const BinaryEncoder::Point* last = nullptr;
+  for (const TextChunk& chunk : chunks)
+  {
+    if (!chunk.points.isEmpty())
+    {
+      sorted = sorted && (!last || !earlier(chunk.points.first(), *last)) &&
+               std::is_sorted(chunk.points.constBegin(), chunk.points.constEnd(), earlier);
+      last = &chunk.points.last();
+      pointCount += chunk.points.size();
+      mChunks << chunk.points;
+    }
+  }
+  if (pointCount > (sorted ? MAX_POINTS : MAX_SORTED_POINTS))
+  {
+    mError = QString(sorted ? "The capture has %1 samples, at most %2 can be plotted"
+                            : "The capture has %1 samples out of time order, at most %2 can be sorted")
+             .arg(pointCount).arg(sorted ? MAX_POINTS : MAX_SORTED_POINTS);
+    return;
+  }
+  if (!sorted)
+  {
+    BinaryEncoder::Data points;
+    for (const BinaryEncoder::Data& chunkPoints : mChunks)
+    {
+      points += chunkPoints;
+    }
+    std::stable_sort(points.begin(), points.end(), earlier);
+    mChunks = {points};
+  }
+}
+
+void CaptureReader::readSamples(const uchar* samples, qint64 size)
+{
+  const Format format = mFormat;
+  const double sampleRate = mSampleRate;
+  const double voltsPerUnit = mVoltsPerUnit;
+  const int bytes = sampleSize(format);
+  const qint64 count = size / bytes;
+  if (count > MAX_POINTS)
+  {
+    mError = QString("The capture has %1 samples, at most %2 can be plotted").arg(count).arg(MAX_POINTS);
+    return;
+  }
+  // A vector of points per chunk, none of them nearly as large as a vector can be
+  const qint64 chunkLength = CHUNK_SIZE / bytes;
+  QVector<SampleChunk> chunks;
+  for (qint64 start = 0; start < count; start += chunkLength)
+  {
+    chunks << SampleChunk {start, BinaryEncoder::Data()};
+  }
+  QtConcurrent::blockingMap(chunks, [=](SampleChunk& chunk)
+  {
+    const qint64 end = qMin(chunk.start + chunkLength, count);
+    chunk.points.resize(int(end - chunk.start));
+    BinaryEncoder::Point* points = chunk.points.data();
+    for (qint64 n = chunk.start; n < end; ++n)
+    {
+      const uchar* sample = samples + n * bytes;
+      double value;
+      switch (format)
+      {
+      case Format::INT8:
+        value = qint8(*sample);
+        break;
+      case Format::INT16:
+        value = qFromLittleEndian<qint16>(sample);
+        break;
+      default:
+      {
+        const quint32 bits = qFromLittleEndian<quint32>(sample);
+        float single;
+        std::memcpy(&single, &bits, sizeof(single));
+        value = single;
+        break;
+      }
+      }
+      *points++ = BinaryEncoder::Point(n / sampleRate, value * voltsPerUnit);
+    }
+  });
+  for (const SampleChunk& chunk : chunks)
+  {
+    mChunks << chunk.points;
+  }
+}
@@ -0,0 +1,75 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2015 Christian González León
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+  */
+
+#ifndef CAPTUREFILE_H
+#define CAPTUREFILE_H
+
+#include "binaryencoder.h"
+
+#include <QString>
+#include <QVector>
+
+namespace chrishenx {
+
+  // Waveforms captured by oscilloscopes and logic analyzers, read as points to be drawn over the
+  // encodings. Text captures have a time in seconds and a level at the start of every line,
+  // separated by commas, semicolons, tabs or spaces, the lines that do not start with two numbers,
+  // like headers, are skipped. Raw captures are little endian samples taken sampleRate times a
+  // second, their levels being the samples times voltsPerUnit.
+  //
+  // The file is mapped and split in chunks parsed in parallel, a text chunk starting at the first
+  // line that starts in it. Numbers are parsed with std::from_chars straight from the mapping. The
+  // points are handed out as the chunks parsed, in order, so they are copied only into the plots
+  class CaptureReader
+  {
+  public:
+    enum class Format { TEXT, INT8, INT16, FLOAT32 };
+
+    static const qint64 CHUNK_SIZE = 1 << 22; // Bytes of a parsing task
+
+    CaptureReader(const QString& fileName, Format format, double sampleRate = 1,
+                  double voltsPerUnit = 1);
+
+    bool read(); // Returns false on failure and errorString() says why
+    // The points of the file in time order, split in consecutive chunks
+    const QVector<BinaryEncoder::Data>& chunks() const { return mChunks; }
+    QVector<BinaryEncoder::Data> takeChunks();
+    QString errorString() const { return mError; }
+
+  private:
+    QString mFileName;
+    Format mFormat;
+    double mSampleRate;
+    double mVoltsPerUnit;
+    QVector<BinaryEncoder::Data> mChunks; // None is empty
+    QString mError;
+
+    void readText(const char* text, qint64 size);
+    void readSamples(const uchar* samples, qint64 size);
+  };
+
+} // chrishenx namespace end
+
+
+#endif // CAPTUREFILE_H
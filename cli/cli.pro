@@ -0,0 +1,12 @@
+QT       += core concurrent
+QT       -= gui
+
+TARGET = binary-encoding-cli
+TEMPLATE = app
+
+CONFIG += console c++17
+CONFIG -= app_bundle
+
+include(../encoder.pri)
+
+SOURCES += main.cpp
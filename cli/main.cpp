@@ -0,0 +1,647 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2015 Christian González León
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+  */
+
+// Headless encoder, it reads a message and writes the signals of any set of methods
+
+#include "binaryencoder.h"
+#include "hexconversion.h"
+#include "mappedfile.h"
+#include "tracing.h"
+#include "vcdwriter.h"
+#include "waveformfile.h"
+#include "waveformwriter.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <iterator>
+#include <memory>
+
+using namespace chrishenx;
+
+namespace {
+
+  struct MethodName
+  {
+    const char* name;
+    BinaryEncoder::Method method;
+  };
+
+  const MethodName METHOD_NAMES[] = {
+    {"clock", BinaryEncoder::Method::CLOCK},
+    {"ttl", BinaryEncoder::Method::TTL},
+    {"nrzl", BinaryEncoder::Method::NRZL},
+    {"nrzi", BinaryEncoder::Method::NRZI},
+    {"bipolar", BinaryEncoder::Method::BIPOLAR},
+    {"pseudoternary", BinaryEncoder::Method::PSEUDOTERNARY},
+    {"manchester", BinaryEncoder::Method::MANCHESTER},
+    {"dmanchester", BinaryEncoder::Method::DMANCHESTER},
+    {"multilevel", BinaryEncoder::Method::MULTILEVEL}
+  };
+
+  enum class OutputFormat { VERTICES, CSV, TSV, PCM, WAV, BEW, VCD };
+
+  struct Options
+  {
+    OutputFormat format;
+    int levels;
+    qint64 chunkBits;
+    int samplesPerBit;
+    int sampleRate; // Of WAV output
+    SampleFormat sampleFormat; // Of WAV output
+    bool edgesOnly; // Of CSV and TSV output
+    double transSpeed;
+    double amplitude;
+  };
+
+  // Every method has its own encoder, so the methods of a chunk can be encoded in parallel
+  struct Channel
+  {
+    QByteArray name;
+    BinaryEncoder::Method method;
+    BinaryEncoder encoder;
+    int stream; // Index in the output files
+  };
+
+  const qint64 DEFAULT_CHUNK_BITS = 1 << 16;
+  const int DEFAULT_SAMPLES_PER_BIT = 16;
+
+  int fail(const QString& message)
+  {
+    fprintf(stderr, "%s: %s\n", qPrintable(QCoreApplication::applicationName()), qPrintable(message));
+    return 1;
+  }
+
+  // Records a Chrome trace while it lives, when it is given a file name
+  struct TraceRecording
+  {
+    explicit TraceRecording(const QString& fileName) : fileName(fileName)
+    {
+      if (!fileName.isEmpty())
+      {
+        Tracer::start(fileName);
+      }
+    }
+
+    ~TraceRecording()
+    {
+      if (Tracer::isRecording() && !Tracer::stop())
+      {
+        fail(QString("cannot write %1: %2").arg(fileName, Tracer::errorString()));
+      }
+    }
+
+    QString fileName;
+  };
+
+  bool isWhitespace(char c)
+  {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+  }
+
+  void trimWhitespace(const char*& text, qint64& length)
+  {
+    while (length > 0 && isWhitespace(*text))
+    {
+      ++text;
+      --length;
+    }
+    while (length > 0 && isWhitespace(text[length - 1]))
+    {
+      --length;
+    }
+  }
+
+  qint64 firstInvalidBit(const char* text, qint64 length)
+  {
+    for (qint64 i = 0; i < length; ++i)
+    {
+      if (text[i] != '0' && text[i] != '1')
+      {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  QByteArray convertChunk(Channel* channel, qint64 first, qint64 count, qint64 bitCount, const Options& options)
+  {
+    BinaryEncoder::Data points = channel->encoder.encodeRange(channel->method, first, count, options.levels);
+    if (first + count < bitCount && points.size() > count * BinaryEncoder::pointsPerBit(channel->method))
+    { // The differential Manchester closing point belongs only to the end of the message
+      points.removeLast();
+    }
+    switch (options.format)
+    {
+    case OutputFormat::VERTICES:
+      return toVertices(points);
+    case OutputFormat::PCM:
+      return toPcm(points, first * options.samplesPerBit, count * options.samplesPerBit,
+                   options.samplesPerBit * options.transSpeed, options.amplitude);
+    case OutputFormat::CSV:
+    case OutputFormat::TSV:
+    case OutputFormat::WAV:
+    case OutputFormat::BEW:
+    case OutputFormat::VCD:
+      break;
+    }
+    return QByteArray();
+  }
+
+  // Encodes chunk by chunk, the methods of every chunk in parallel, and writes every chunk before
+  // going on. Vertices and PCM to the standard output
+  int writeStreamed(QList<Channel>& channels, const QStringList& paths, const Options& options)
+  {
+    std::vector<std::unique_ptr<QFile>> outputs;
+    for (const QString& path : paths)
+    {
+      outputs.emplace_back(new QFile(path == "-" ? QString() : path));
+      const bool opened = path == "-" ? outputs.back()->open(stdout, QIODevice::WriteOnly)
+                                      : outputs.back()->open(QIODevice::WriteOnly);
+      if (!opened)
+      {
+        return fail(QString("cannot write %1: %2").arg(path, outputs.back()->errorString()));
+      }
+    }
+    const qint64 bitCount = channels.first().encoder.bitCount();
+    for (qint64 first = 0; first < bitCount; first += options.chunkBits)
+    {
+      const qint64 count = qMin(options.chunkBits, bitCount - first);
+      QList<QFuture<QByteArray>> chunks;
+      for (Channel& channel : channels)
+      {
+        Channel* chunkChannel = &channel;
+        chunks << QtConcurrent::run([=]() { return convertChunk(chunkChannel, first, count, bitCount, options); });
+      }
+      QVector<QList<QByteArray>> streams(int(outputs.size()));
+      for (int i = 0; i < channels.size(); ++i)
+      {
+        streams[channels[i].stream] << chunks[i].result();
+      }
+      for (int i = 0; i < streams.size(); ++i)
+      {
+        const QByteArray chunk = options.format == OutputFormat::PCM ? interleavePcm(streams[i])
+                                                                     : streams[i].join();
+        if (outputs[i]->write(chunk) != chunk.size())
+        {
+          return fail(QString("cannot write %1: %2").arg(paths[i], outputs[i]->errorString()));
+        }
+      }
+    }
+    for (int i = 0; i < int(outputs.size()); ++i)
+    {
+      if (!outputs[i]->flush())
+      {
+        return fail(QString("cannot write %1: %2").arg(paths[i], outputs[i]->errorString()));
+      }
+    }
+    return 0;
+  }
+
+  // One waveform file or value change dump with a track per method, the methods of every chunk
+  // encoded in parallel
+  int writeContainer(QList<Channel>& channels, const QString& path, const Options& options)
+  {
+    QFile output(path == "-" ? QString() : path);
+    const bool opened = path == "-" ? output.open(stdout, QIODevice::WriteOnly)
+                                    : output.open(QIODevice::WriteOnly);
+    if (!opened)
+    {
+      return fail(QString("cannot write %1: %2").arg(path, output.errorString()));
+    }
+    QVector<WaveformTrack> tracks;
+    QList<QByteArray> names;
+    for (const Channel& channel : channels)
+    {
+      tracks << WaveformTrack {channel.method, options.levels};
+      names << channel.name;
+    }
+    const qint64 bitCount = channels.first().encoder.bitCount();
+    const bool dump = options.format == OutputFormat::VCD;
+    WaveformFileWriter writer(&output);
+    VcdWriter dumpWriter(&output);
+    bool written = dump ? dumpWriter.begin(options.transSpeed, options.amplitude, bitCount, tracks, names)
+                        : writer.begin(options.transSpeed, options.amplitude, bitCount, tracks);
+    for (qint64 first = 0; written && first < bitCount; first += options.chunkBits)
+    {
+      const qint64 count = qMin(options.chunkBits, bitCount - first);
+      QList<QFuture<BinaryEncoder::Data>> chunks;
+      for (Channel& channel : channels)
+      {
+        Channel* chunkChannel = &channel;
+        chunks << QtConcurrent::run([=]()
+        {
+          return chunkChannel->encoder.encodeRange(chunkChannel->method, first, count, options.levels);
+        });
+      }
+      QVector<BinaryEncoder::Data> points;
+      for (int i = 0; i < chunks.size(); ++i)
+      {
+        points << chunks[i].result(); // Waiting for every task
+        written = written && (dump || writer.append(i, points.last()));
+      }
+      written = written && (!dump || dumpWriter.append(points));
+    }
+    written = written && (dump ? dumpWriter.finish(bitCount) : writer.finish());
+    if (!written || !output.flush())
+    {
+      return fail(QString("cannot write %1: %2").arg(path, dump ? dumpWriter.errorString()
+                                                                : output.errorString()));
+    }
+    return 0;
+  }
+
+  // Delimited text, the chunks of every output formatted in parallel and written in order. The
+  // methods sharing an output are encoded with the encoder of the first of them
+  int writeDelimited(QList<Channel>& channels, const QStringList& paths, const Options& options)
+  {
+    for (int i = 0; i < paths.size(); ++i)
+    {
+      QFile output(paths[i] == "-" ? QString() : paths[i]);
+      const bool opened = paths[i] == "-" ? output.open(stdout, QIODevice::WriteOnly)
+                                          : output.open(QIODevice::WriteOnly);
+      if (!opened)
+      {
+        return fail(QString("cannot write %1: %2").arg(paths[i], output.errorString()));
+      }
+      BinaryEncoder* encoder = nullptr;
+      QVector<WaveformTrack> tracks;
+      QList<QByteArray> labels;
+      for (Channel& channel : channels)
+      {
+        if (channel.stream == i)
+        {
+          encoder = encoder ? encoder : &channel.encoder;
+          tracks << WaveformTrack {channel.method, options.levels};
+          labels << channel.name;
+        }
+      }
+      const char separator = options.format == OutputFormat::TSV ? '\t' : ',';
+      if (!writeCsv(&output, *encoder, tracks, labels, separator, options.edgesOnly, options.chunkBits) ||
+          !output.flush())
+      {
+        return fail(QString("cannot write %1: %2").arg(paths[i], output.errorString()));
+      }
+    }
+    return 0;
+  }
+
+  // A WAV file with a channel per method, encoded and rendered a block of samples at a time
+  int writeWav(QList<Channel>& channels, const QString& path, const Options& options)
+  {
+    QFile output(path == "-" ? QString() : path);
+    const bool opened = path == "-" ? output.open(stdout, QIODevice::WriteOnly)
+                                    : output.open(QIODevice::WriteOnly);
+    if (!opened)
+    {
+      return fail(QString("cannot write %1: %2").arg(path, output.errorString()));
+    }
+    QVector<WaveformTrack> tracks;
+    for (const Channel& channel : channels)
+    {
+      tracks << WaveformTrack {channel.method, options.levels};
+    }
+    if (!writeAudio(&output, channels.first().encoder, tracks, options.sampleRate, options.sampleFormat, true) ||
+        !output.flush())
+    {
+      return fail(QString("cannot write %1: %2").arg(path, output.errorString()));
+    }
+    return 0;
+  }
+
+  qint64 pointCount(const Channel& channel)
+  {
+    const qint64 bitCount = channel.encoder.bitCount();
+    const bool closed = channel.method == BinaryEncoder::Method::DMANCHESTER && bitCount > 0 &&
+                        !channel.encoder.bits().bit(bitCount - 1);
+    return bitCount * BinaryEncoder::pointsPerBit(channel.method) + (closed ? 1 : 0);
+  }
+
+  // Vertices and PCM have fixed size records, so the size of every output is known before encoding
+  // and every chunk has its place in it. The outputs are allocated and mapped, then all the chunks
+  // of all the methods are encoded in parallel straight into the mappings
+  int writeMapped(QList<Channel>& channels, const QStringList& paths, const Options& options)
+  {
+    static_assert(sizeof(BinaryEncoder::Point) == 2 * sizeof(double), "Points are not vertices");
+    QVector<int> channelCounts(paths.size(), 0);
+    QVector<int> channelIndexes; // Of every channel within its output
+    for (const Channel& channel : channels)
+    {
+      channelIndexes << channelCounts[channel.stream]++;
+    }
+    const qint64 bitCount = channels.first().encoder.bitCount();
+    std::vector<std::unique_ptr<MappedFile>> outputs;
+    for (int i = 0; i < paths.size(); ++i)
+    {
+      // Vertex outputs have a single channel
+      const qint64 size = options.format == OutputFormat::VERTICES
+          ? pointCount(channels[i]) * qint64(sizeof(BinaryEncoder::Point))
+          : bitCount * options.samplesPerBit * channelCounts[i] * qint64(sizeof(qint16));
+      outputs.emplace_back(new MappedFile(paths[i]));
+      if (!outputs.back()->create(size))
+      {
+        return fail(QString("cannot write %1: %2").arg(paths[i], outputs.back()->errorString()));
+      }
+    }
+    QtConcurrent::blockingMap(channels, [&](Channel& channel)
+    {
+      channel.encoder.buildCheckpoints(options.levels);
+    });
+
+    struct ChunkTask
+    {
+      const Channel* channel;
+      int channelIndex;
+      qint64 first;
+      qint64 count;
+    };
+    QVector<ChunkTask> tasks;
+    for (int i = 0; i < channels.size(); ++i)
+    {
+      for (qint64 first = 0; first < bitCount; first += options.chunkBits)
+      {
+        tasks << ChunkTask {&channels[i], channelIndexes[i], first, qMin(options.chunkBits, bitCount - first)};
+      }
+    }
+    QtConcurrent::blockingMap(tasks, [&](const ChunkTask& task)
+    {
+      const Channel& channel = *task.channel;
+      const int pointsPerBit = BinaryEncoder::pointsPerBit(channel.method);
+      uchar* out = outputs[size_t(channel.stream)]->data();
+      if (options.format == OutputFormat::VERTICES)
+      {
+        BinaryEncoder::Point* points = reinterpret_cast<BinaryEncoder::Point*>(out);
+        channel.encoder.encodeRangeInto(channel.method, task.first, task.count, options.levels,
+                                        points + task.first * pointsPerBit);
+      }
+      else
+      { // Sampling needs the points of the chunk, only those are held
+        BinaryEncoder::Data points(int(task.count * pointsPerBit + 1));
+        points.resize(int(channel.encoder.encodeRangeInto(channel.method, task.first, task.count,
+                                                          options.levels, points.data())));
+        const int channelCount = channelCounts[channel.stream];
+        qint16* samples = reinterpret_cast<qint16*>(out);
+        writePcm(points, task.first * options.samplesPerBit, task.count * options.samplesPerBit,
+                 options.samplesPerBit * options.transSpeed, options.amplitude,
+                 samples + task.first * options.samplesPerBit * channelCount + task.channelIndex,
+                 channelCount);
+      }
+    });
+    return 0;
+  }
+
+} // anonymous namespace end
+
+int main(int argc, char *argv[])
+{
+  QCoreApplication app(argc, argv);
+  app.setApplicationName("binary-encoding-cli");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Encodes a binary message with line coding methods.");
+  parser.addHelpOption();
+  parser.addPositionalArgument("input", "Message file, standard input when it is - or missing. Files "
+                               "are mapped into memory, so they can be larger than the RAM.", "[input]");
+  const QCommandLineOption inputFormatOption({"i", "input-format"},
+      "Message format: hex, bin (ASCII 0 and 1) or raw (the bytes themselves). Whitespace "
+      "around hex and bin digits is ignored.", "format", "hex");
+  const QCommandLineOption methodsOption({"m", "methods"},
+      "Comma separated methods: clock, ttl, nrzl, nrzi, bipolar, pseudoternary, manchester, "
+      "dmanchester, multilevel.", "list", "nrzl");
+  const QCommandLineOption levelsOption({"l", "levels"}, "Levels of the multilevel method: 2, 4 or 8.",
+                                        "levels", QString::number(BinaryEncoder::DEFAULT_LEVELS));
+  const QCommandLineOption formatOption({"f", "format"},
+      "Output format: vertices (time and level doubles), csv, tsv, pcm (signed 16 bit samples, one "
+      "channel per method sharing the output), wav (a channel per method), bew (binary waveform "
+      "file with every method, it opens in the application) or vcd (value change dump with every "
+      "method).", "format", "csv");
+  const QCommandLineOption outputOption({"o", "output"},
+      "Output file, standard output when it is -. A %m in it is replaced by the method name to "
+      "write every method to its own file. Vertices and PCM files are allocated up front and "
+      "encoded straight into a mapping of them.", "file", "-");
+  const QCommandLineOption threadsOption({"j", "threads"}, "Chunks encoded at the same time.",
+                                         "count", QString::number(QThread::idealThreadCount()));
+  const QCommandLineOption chunkOption({"c", "chunk-bits"}, "Bits encoded and written at a time.",
+                                       "bits", QString::number(DEFAULT_CHUNK_BITS));
+  const QCommandLineOption samplesOption("samples-per-bit", "PCM samples per bit.", "samples",
+                                         QString::number(DEFAULT_SAMPLES_PER_BIT));
+  const QCommandLineOption sampleRateOption("sample-rate",
+      "WAV samples per second, the samples per bit times the speed by default.", "hz");
+  const QCommandLineOption edgesOption("edges", "Only the CSV and TSV rows where the level changes.");
+  const QCommandLineOption floatOption("float", "32 bit float WAV samples instead of 16 bit integers.");
+  const QCommandLineOption speedOption("speed", "Transmission speed in bits per second.", "bps",
+                                       QString::number(BinaryEncoder::DEFAULT_TRANS_SPEED));
+  const QCommandLineOption amplitudeOption("amplitude", "Signal amplitude in volts.", "volts",
+                                           QString::number(BinaryEncoder::DEFAULT_AMPLITUDE));
+  const QCommandLineOption traceOption("trace",
+      "Chrome trace file the time spent is recorded to, it loads in chrome://tracing or Perfetto.",
+      "file");
+  parser.addOptions({inputFormatOption, methodsOption, levelsOption, formatOption, outputOption,
+                     threadsOption, chunkOption, samplesOption, sampleRateOption, edgesOption,
+                     floatOption, speedOption, amplitudeOption, traceOption});
+  parser.process(app);
+  const TraceRecording traceRecording(parser.value(traceOption));
+
+  Options options;
+  const QString format = parser.value(formatOption);
+  if (format == "vertices")
+  {
+    options.format = OutputFormat::VERTICES;
+  }
+  else if (format == "csv")
+  {
+    options.format = OutputFormat::CSV;
+  }
+  else if (format == "tsv")
+  {
+    options.format = OutputFormat::TSV;
+  }
+  else if (format == "pcm")
+  {
+    options.format = OutputFormat::PCM;
+  }
+  else if (format == "wav")
+  {
+    options.format = OutputFormat::WAV;
+  }
+  else if (format == "bew")
+  {
+    options.format = OutputFormat::BEW;
+  }
+  else if (format == "vcd")
+  {
+    options.format = OutputFormat::VCD;
+  }
+  else
+  {
+    return fail(QString("unknown output format %1").arg(format));
+  }
+  bool levelsOk, threadsOk, chunkOk, samplesOk, speedOk, amplitudeOk;
+  options.levels = parser.value(levelsOption).toInt(&levelsOk);
+  const int threads = parser.value(threadsOption).toInt(&threadsOk);
+  options.chunkBits = parser.value(chunkOption).toLongLong(&chunkOk);
+  options.samplesPerBit = parser.value(samplesOption).toInt(&samplesOk);
+  options.transSpeed = parser.value(speedOption).toDouble(&speedOk);
+  options.amplitude = parser.value(amplitudeOption).toDouble(&amplitudeOk);
+  if (!levelsOk || (options.levels != 2 && options.levels != 4 && options.levels != 8))
+  {
+    return fail("the levels must be 2, 4 or 8");
+  }
+  if (!threadsOk || threads < 1 || !chunkOk || options.chunkBits < 1 || !samplesOk ||
+      options.samplesPerBit < 1 || !speedOk || options.transSpeed <= 0 || !amplitudeOk ||
+      options.amplitude <= 0)
+  {
+    return fail("the threads, chunk bits, samples per bit, speed and amplitude must be positive");
+  }
+  const double sampleRate = parser.isSet(sampleRateOption) ? parser.value(sampleRateOption).toDouble()
+                                                            : options.samplesPerBit * options.transSpeed;
+  if (options.format == OutputFormat::WAV &&
+      (sampleRate < 1 || sampleRate > INT_MAX || sampleRate != qRound(sampleRate)))
+  {
+    return fail("the sample rate must be a positive whole number of hertz");
+  }
+  options.sampleRate = options.format == OutputFormat::WAV ? qRound(sampleRate) : 0;
+  options.sampleFormat = parser.isSet(floatOption) ? SampleFormat::FLOAT32 : SampleFormat::INT16;
+  options.edgesOnly = parser.isSet(edgesOption);
+  QThreadPool::globalInstance()->setMaxThreadCount(threads);
+
+  // Reading the message, files are mapped and the bits of raw ones are never copied
+  const QStringList positional = parser.positionalArguments();
+  const QString inputPath = positional.isEmpty() ? QString("-") : positional.first();
+  MappedFile mappedInput(inputPath);
+  QByteArray stdinInput;
+  const char* text;
+  qint64 length;
+  if (inputPath == "-")
+  {
+    QFile input;
+    if (!input.open(stdin, QIODevice::ReadOnly))
+    {
+      return fail(QString("cannot read the standard input: %1").arg(input.errorString()));
+    }
+    stdinInput = input.readAll();
+    text = stdinInput.constData();
+    length = stdinInput.size();
+  }
+  else
+  {
+    if (!mappedInput.map())
+    {
+      return fail(QString("cannot read %1: %2").arg(inputPath, mappedInput.errorString()));
+    }
+    text = reinterpret_cast<const char*>(mappedInput.data());
+    length = mappedInput.size();
+  }
+  BitBuffer bits;
+  const QString inputFormat = parser.value(inputFormatOption);
+  if (inputFormat == "raw")
+  { // Used in place, whatever its size
+    bits = BitBuffer::fromRawData(reinterpret_cast<const uchar*>(text), length * 8);
+  }
+  else if (inputFormat == "hex" || inputFormat == "bin")
+  {
+    trimWhitespace(text, length);
+    // The digits are packed into a buffer of their own, which has to fit in a QByteArray
+    if (length > BitBuffer::MAX_SIZE / (inputFormat == "hex" ? 4 : 1))
+    {
+      return fail(QString("%1 is too large, at most %2 bits of %3 digits can be encoded")
+                  .arg(inputPath).arg(BitBuffer::MAX_SIZE).arg(inputFormat));
+    }
+    const qint64 invalidPosition = inputFormat == "hex" ? firstInvalidHexDigit(text, length)
+                                                        : firstInvalidBit(text, length);
+    if (invalidPosition != -1)
+    {
+      return fail(QString("invalid %1 digit at position %2").arg(inputFormat).arg(invalidPosition + 1));
+    }
+    bits = inputFormat == "hex" ? hexToBits(text, length)
+                                : BitBuffer::fromBitString(text, length);
+  }
+  else
+  {
+    return fail(QString("unknown input format %1").arg(inputFormat));
+  }
+
+  // One channel per method, the channels are written to one or to their own output
+  const QString outputPath = parser.value(outputOption);
+  const bool ownOutputs = outputPath.contains("%m");
+  QList<Channel> channels;
+  for (const QString& name : parser.value(methodsOption).split(',', QString::SkipEmptyParts))
+  {
+    const MethodName* method = std::find_if(std::begin(METHOD_NAMES), std::end(METHOD_NAMES),
+                                            [&](const MethodName& m) { return name.trimmed() == m.name; });
+    if (method == std::end(METHOD_NAMES))
+    {
+      return fail(QString("unknown method %1").arg(name));
+    }
+    channels << Channel {method->name, method->method,
+                         BinaryEncoder(bits, options.transSpeed, options.amplitude),
+                         ownOutputs ? channels.size() : 0};
+    // The chunks are encoded in order, a checkpoint per chunk is all they need
+    channels.last().encoder.setCheckpointInterval(int(qMin(options.chunkBits, qint64(INT_MAX))));
+  }
+  if (channels.isEmpty())
+  {
+    return fail("no method to encode");
+  }
+  if (options.format == OutputFormat::BEW || options.format == OutputFormat::VCD)
+  {
+    if (ownOutputs)
+    {
+      return fail("a waveform file holds every method, there is no %m for it");
+    }
+    return writeContainer(channels, outputPath, options);
+  }
+  if (options.format == OutputFormat::WAV)
+  {
+    if (ownOutputs)
+    {
+      return fail("a WAV file holds every method as a channel, there is no %m for it");
+    }
+    return writeWav(channels, outputPath, options);
+  }
+  if (options.format == OutputFormat::VERTICES && !ownOutputs && channels.size() > 1)
+  {
+    return fail("the vertices of several methods need their own outputs, put %m in the output");
+  }
+  QStringList outputPaths;
+  for (int i = 0; i < (ownOutputs ? channels.size() : 1); ++i)
+  {
+    outputPaths << QString(outputPath).replace("%m", channels[i].name);
+  }
+  if (options.format == OutputFormat::CSV || options.format == OutputFormat::TSV)
+  {
+    return writeDelimited(channels, outputPaths, options);
+  }
+  if (!outputPaths.contains("-"))
+  {
+    return writeMapped(channels, outputPaths, options);
+  }
+  return writeStreamed(channels, outputPaths, options);
+}
@@ -0,0 +1,27 @@
+# Encoding core shared by every target, it needs nothing but QtCore and QtConcurrent
+
+QT += concurrent
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/binaryencoder.cpp \
+    $$PWD/bitbuffer.cpp \
+    $$PWD/capturefile.cpp \
+    $$PWD/hexconversion.cpp \
+    $$PWD/mappedfile.cpp \
+    $$PWD/tracing.cpp \
+    $$PWD/vcdwriter.cpp \
+    $$PWD/waveformfile.cpp \
+    $$PWD/waveformwriter.cpp
+
+HEADERS += \
+    $$PWD/binaryencoder.h \
+    $$PWD/bitbuffer.h \
+    $$PWD/capturefile.h \
+    $$PWD/hexconversion.h \
+    $$PWD/mappedfile.h \
+    $$PWD/tracing.h \
+    $$PWD/vcdwriter.h \
+    $$PWD/waveformfile.h \
+    $$PWD/waveformwriter.h
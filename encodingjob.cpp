@@ -0,0 +1,143 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2015 Christian González León
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+  */
+
+#include "encodingjob.h"
+#include "tracing.h"
+
+#include <QtConcurrent>
+
+using namespace chrishenx;
+
+EncodingJob::EncodingJob(QObject* parent)
+  : QObject(parent)
+{
+}
+
+EncodingJob::~EncodingJob()
+{
+  // Workers emit through this object, none may outlive it
+  cancel();
+  for (QFuture<Result>& future : mFutures)
+  {
+    future.waitForFinished();
+  }
+}
+
+QFuture<EncodingJob::Result> EncodingJob::start(const BitBuffer& bits, const QVector<Trace>& traces)
+{
+  cancel();
+  for (auto it = mFutures.begin(); it != mFutures.end();)
+  {
+    it = it->isFinished() ? mFutures.erase(it) : it + 1;
+  }
+  mCancelled = QSharedPointer<QAtomicInt>(new QAtomicInt(0));
+  QFuture<Result> future = QtConcurrent::run(&EncodingJob::run, this, bits, traces, ++mId, mCancelled);
+  mFutures << future;
+  return future;
+}
+
+void EncodingJob::cancel()
+{
+  if (mCancelled)
+  {
+    mCancelled->store(1);
+  }
+}
+
+bool EncodingJob::isRunning() const
+{
+  return !mFutures.isEmpty() && mFutures.last().isRunning() && !mCancelled->load();
+}
+
+void EncodingJob::prependPoints(QCPDataMap* data, const BinaryEncoder::Data& points)
+{
+  TraceScope traceScope("EncodingJob::prependPoints");
+  for (int i = points.size() - 1; i >= 0; --i)
+  {
+    data->insertMulti(data->constBegin(), points[i].first, QCPData(points[i].first, points[i].second));
+  }
+}
+
+bool EncodingJob::isCurrent(const Result& result) const
+{
+  return !result.cancelled && result.id == mId && !mCancelled->load();
+}
+
+EncodingJob::Result EncodingJob::run(EncodingJob* job, BitBuffer bits, QVector<Trace> traces, int id,
+                                     QSharedPointer<QAtomicInt> cancelled)
+{
+  Result result;
+  result.id = id;
+  result.timeMax = bits.size() / BinaryEncoder(bits).transSpeed();
+  Progress progress;
+  progress.done.store(0);
+  progress.total = qMax(qint64(1), bits.size() * traces.size());
+  progress.percent.store(-1);
+
+  // The traces are independent, all but the first are queued to the pool and the first one is
+  // encoded right here. Waiting on a task that no thread has picked yet runs it on this thread,
+  // so the join never leaves a pool thread idle
+  QList<QFuture<QCPDataMap*>> tasks;
+  for (int i = 1; i < traces.size(); ++i)
+  {
+    tasks << QtConcurrent::run(&EncodingJob::encodeTrace, job, bits, traces[i], cancelled, &progress);
+  }
+  if (!traces.isEmpty())
+  {
+    result.data << encodeTrace(job, bits, traces.first(), cancelled, &progress);
+  }
+  for (QFuture<QCPDataMap*>& task : tasks)
+  {
+    result.data << task.result();
+  }
+  result.cancelled = cancelled->load();
+  return result;
+}
+
+QCPDataMap* EncodingJob::encodeTrace(EncodingJob* job, BitBuffer bits, Trace trace,
+                                     QSharedPointer<QAtomicInt> cancelled, Progress* progress)
+{
+  TraceScope traceScope("EncodingJob::encodeTrace");
+  QCPDataMap* data = new QCPDataMap;
+  BinaryEncoder encoder(bits); // Its checkpoints are not shareable between threads
+  // Chunks go backwards because insertMulti puts the newest of equal keys first, that keeps the
+  // order of the two points of a vertical edge and lets every insert be hinted at begin()
+  for (qint64 end = bits.size(); end > 0 && !cancelled->load(); end -= CHUNK_BITS)
+  {
+    const qint64 first = qMax(qint64(0), end - CHUNK_BITS);
+    prependPoints(data, encoder.encodeRange(trace.method, first, end - first, trace.levels));
+    const qint64 done = progress->done.fetchAndAddRelaxed(end - first) + (end - first);
+    const int percent = int(done * 100 / progress->total);
+    // Only the task that moves the percentage forward reports it
+    int last = progress->percent.load();
+    while (percent > last && !progress->percent.testAndSetOrdered(last, percent, last))
+    {
+    }
+    if (percent > last && !cancelled->load())
+    {
+      emit job->progressChanged(percent);
+    }
+  }
+  return data;
+}
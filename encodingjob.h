@@ -0,0 +1,96 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2015 Christian González León
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+  */
+
+#ifndef ENCODINGJOB_H
+#define ENCODINGJOB_H
+
+#include "binaryencoder.h"
+#include "waveformfile.h"
+#include "qcustomplot/qcustomplot.h"
+
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include <QFuture>
+#include <QObject>
+#include <QSharedPointer>
+
+namespace chrishenx {
+
+  // Encodes a message into plot data on the global thread pool. Every trace is a task of its own
+  // and the work is split in chunks so progress can be reported and the job stopped in between,
+  // by cancel() or by a newer start().
+  class EncodingJob : public QObject
+  {
+    Q_OBJECT
+
+  public:
+    static const int CHUNK_BITS = 1 << 16;
+
+    using Trace = WaveformTrack;
+
+    struct Result
+    {
+      int id; // Of the start() call that produced it
+      bool cancelled;
+      QVector<QCPDataMap*> data; // One per trace, owned by whoever takes the result
+      double timeMax;
+    };
+
+    explicit EncodingJob(QObject* parent = 0);
+    ~EncodingJob();
+
+    QFuture<Result> start(const BitBuffer& bits, const QVector<Trace>& traces);
+    void cancel();
+    bool isRunning() const;
+    bool isCurrent(const Result& result) const; // Not cancelled, not replaced by a newer start()
+
+    // Inserts points, in order and all before the points already in data
+    static void prependPoints(QCPDataMap* data, const BinaryEncoder::Data& points);
+
+  signals:
+    void progressChanged(int percent);
+
+  private:
+    int mId = 0;
+    QSharedPointer<QAtomicInt> mCancelled;
+    QList<QFuture<Result>> mFutures; // Including cancelled ones still winding down
+
+    // Shared by the tasks of one start()
+    struct Progress
+    {
+      QAtomicInteger<qint64> done;
+      qint64 total;
+      QAtomicInt percent;
+    };
+
+    static Result run(EncodingJob* job, BitBuffer bits, QVector<Trace> traces, int id,
+                      QSharedPointer<QAtomicInt> cancelled);
+    static QCPDataMap* encodeTrace(EncodingJob* job, BitBuffer bits, Trace trace,
+                                   QSharedPointer<QAtomicInt> cancelled, Progress* progress);
+  };
+
+} // chrishenx namespace end
+
+
+#endif // ENCODINGJOB_H
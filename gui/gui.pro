@@ -0,0 +1,13 @@
+QT       += core gui
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets printsupport concurrent
+
+TARGET = binary-encoding
+TEMPLATE = app
+
+CONFIG += c++17
+
+include(../encoder.pri)
+include(../window.pri)
+
+SOURCES += ../main.cpp
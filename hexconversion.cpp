@@ -0,0 +1,235 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2015 Christian González León
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+  */
+
+#include "hexconversion.h"
+#include "tracing.h"
+
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace chrishenx;
+
+namespace {
+
+  static const uchar INVALID = 0xFF;
+
+  struct NibbleTable
+  {
+    uchar values[256]; // INVALID for anything but a hexadecimal digit
+    quint64 bitChars[16]; // Four '0'/'1' UTF-16 code units per nibble
+
+    NibbleTable()
+    {
+      memset(values, INVALID, sizeof(values));
+      for (int c = '0'; c <= '9'; ++c)
+      {
+        values[c] = uchar(c - '0');
+      }
+      for (int c = 'A'; c <= 'F'; ++c)
+      {
+        values[c] = values[c + 'a' - 'A'] = uchar(c - 'A' + 10);
+      }
+      for (int nibble = 0; nibble < 16; ++nibble)
+      {
+        ushort chars[4];
+        for (int bit = 0; bit < 4; ++bit)
+        {
+          chars[bit] = (nibble >> (3 - bit)) & 1 ? '1' : '0';
+        }
+        memcpy(&bitChars[nibble], chars, sizeof(chars));
+      }
+    }
+  };
+
+  const NibbleTable NIBBLES;
+
+  inline uchar nibble(ushort c)
+  {
+    return c < 256 ? NIBBLES.values[c] & 0x0F : 0;
+  }
+
+  inline bool isHexDigit(ushort c)
+  {
+    return c < 256 && NIBBLES.values[c] != INVALID;
+  }
+
+#ifdef __SSE2__
+
+  // Bit i is set when byte i is an ASCII hex digit. Bytes from 0x80 up compare as negative.
+  inline int hexDigitMask(__m128i c)
+  {
+    const __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)),
+                                        _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+    const __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+    const __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                         _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+    return _mm_movemask_epi8(_mm_or_si128(digit, letter));
+  }
+
+  // Narrows 16 UTF-16 code units to bytes, saturation turns anything past Latin-1 into 0x00 or
+  // 0xFF, neither of them a hex digit
+  inline __m128i narrow(const ushort* chars)
+  {
+    return _mm_packus_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(chars)),
+                            _mm_loadu_si128(reinterpret_cast<const __m128i*>(chars + 8)));
+  }
+
+  // Turns 16 ASCII hex digits into 16 nibbles
+  inline __m128i nibbles(__m128i c)
+  {
+    const __m128i isDigit = _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1));
+    const __m128i digit = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+    const __m128i letter = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a' - 10));
+    return _mm_or_si128(_mm_and_si128(isDigit, digit), _mm_andnot_si128(isDigit, letter));
+  }
+
+  // Packs 16 nibbles into 8 bytes, the first nibble of each pair being the high one
+  inline void storePacked(uchar* out, __m128i nibbles)
+  {
+    const __m128i high = _mm_slli_epi16(_mm_and_si128(nibbles, _mm_set1_epi16(0x00FF)), 4);
+    const __m128i low = _mm_srli_epi16(nibbles, 8);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out),
+                     _mm_packus_epi16(_mm_or_si128(high, low), _mm_setzero_si128()));
+  }
+
+#endif
+
+  template <typename Char>
+  void packTail(const Char* hex, qint64 from, qint64 length, uchar* out)
+  {
+    for (qint64 i = from; i + 1 < length; i += 2)
+    {
+      out[i / 2] = uchar(nibble(hex[i]) << 4 | nibble(hex[i + 1]));
+    }
+    if (length % 2)
+    {
+      out[length / 2] = uchar(nibble(hex[length - 1]) << 4);
+    }
+  }
+
+  template <typename Char>
+  qint64 firstInvalidFrom(const Char* hex, qint64 from, qint64 length)
+  {
+    for (qint64 i = from; i < length; ++i)
+    {
+      if (!isHexDigit(hex[i]))
+      {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+} // anonymous namespace end
+
+qint64 chrishenx::firstInvalidHexDigit(const char* hex, qint64 length)
+{
+  qint64 i = 0;
+#ifdef __SSE2__
+  // 32 characters per step, the exact position is only looked for once a step fails
+  for (; i + 32 <= length; i += 32)
+  {
+    const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hex + i));
+    const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hex + i + 16));
+    if ((hexDigitMask(c) & hexDigitMask(d)) != 0xFFFF)
+    {
+      break;
+    }
+  }
+#endif
+  return firstInvalidFrom(reinterpret_cast<const uchar*>(hex), i, length);
+}
+
+qint64 chrishenx::firstInvalidHexDigit(const QString& hex)
+{
+  const ushort* chars = hex.utf16();
+  const qint64 length = hex.length();
+  qint64 i = 0;
+#ifdef __SSE2__
+  for (; i + 32 <= length; i += 32)
+  {
+    const int mask = hexDigitMask(narrow(chars + i)) & hexDigitMask(narrow(chars + i + 16));
+    if (mask != 0xFFFF)
+    {
+      break;
+    }
+  }
+#endif
+  return firstInvalidFrom(chars, i, length);
+}
+
+BitBuffer chrishenx::hexToBits(const char* hex, qint64 length)
+{
+  TraceScope traceScope("hexToBits");
+  if (length > BitBuffer::MAX_SIZE / 4)
+  {
+    return BitBuffer();
+  }
+  BitBuffer bits(length * 4);
+  uchar* out = bits.data();
+  qint64 i = 0;
+#ifdef __SSE2__
+  for (; i + 16 <= length; i += 16)
+  {
+    const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hex + i));
+    storePacked(out + i / 2, nibbles(c));
+  }
+#endif
+  packTail(reinterpret_cast<const uchar*>(hex), i, length, out);
+  return bits;
+}
+
+BitBuffer chrishenx::hexToBits(const QString& hex)
+{
+  TraceScope traceScope("hexToBits");
+  const ushort* chars = hex.utf16();
+  const qint64 length = hex.length();
+  BitBuffer bits(length * 4);
+  uchar* out = bits.data();
+  qint64 i = 0;
+#ifdef __SSE2__
+  for (; i + 16 <= length; i += 16)
+  {
+    storePacked(out + i / 2, nibbles(narrow(chars + i)));
+  }
+#endif
+  packTail(chars, i, length, out);
+  return bits;
+}
+
+QString chrishenx::hexToBitString(const QString& hex)
+{
+  TraceScope traceScope("hexToBitString");
+  const ushort* chars = hex.utf16();
+  QString bits(hex.length() * 4, Qt::Uninitialized);
+  ushort* out = reinterpret_cast<ushort*>(bits.data());
+  for (int i = 0; i < hex.length(); ++i)
+  {
+    memcpy(out + i * 4, &NIBBLES.bitChars[nibble(chars[i])], sizeof(quint64));
+  }
+  return bits;
+}
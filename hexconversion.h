@@ -0,0 +1,47 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2015 Christian González León
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+  */
+
+#ifndef HEXCONVERSION_H
+#define HEXCONVERSION_H
+
+#include "bitbuffer.h"
+
+#include <QString>
+
+namespace chrishenx {
+
+  // Position of the first character that is not a hexadecimal digit, -1 if there is none
+  qint64 firstInvalidHexDigit(const QString& hex);
+  qint64 firstInvalidHexDigit(const char* hex, qint64 length);
+
+  // The digits are assumed to be valid hexadecimal, any length up to BitBuffer::MAX_SIZE / 4 is
+  // accepted and longer input gives an empty buffer
+  BitBuffer hexToBits(const QString& hex);
+  BitBuffer hexToBits(const char* hex, qint64 length);
+  QString hexToBitString(const QString& hex);
+
+} // chrishenx namespace end
+
+
+#endif // HEXCONVERSION_H
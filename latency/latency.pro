@@ -0,0 +1,14 @@
+QT       += core gui
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets printsupport concurrent
+
+TARGET = binary-encoding-latency
+TEMPLATE = app
+
+CONFIG += console c++17
+CONFIG -= app_bundle
+
+include(../encoder.pri)
+include(../window.pri)
+
+SOURCES += main.cpp
@@ -0,0 +1,267 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2015 Christian González León
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+  */
+
+// Drives the main window offscreen as a user would, typing messages, toggling methods and clicking
+// the encode button, and reports percentiles of the time every stage takes until the encoding is
+// on screen
+
+#include "mainwindow.h"
+#include "qcustomplot/qcustomplot.h"
+#include "tracing.h"
+
+#include <QApplication>
+#include <QCheckBox>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QKeyEvent>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QTimer>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+namespace {
+
+  const qint64 SIZES[] = {64, 1 << 10, 1 << 14, 1 << 17, 1 << 20}; // In bits
+  const qint64 DEFAULT_MAX_BITS = 1 << 20;
+  const int DEFAULT_ITERATIONS = 50;
+  const int FRAME_TIMEOUT = 60000; // ms
+  const int WINDOW_WIDTH = 1280; // px
+  const int WINDOW_HEIGHT = 900; // px
+
+  // Toggled one per iteration, so the number of traces changes along the run
+  const char* const METHOD_CHECK_BOXES[] = {
+    "manch_checkBox", "bip_checkBox", "mlevel_checkBox", "manchd_checkBox", "pset_checkBox"
+  };
+
+  const char* const STAGES[] = {"conversion", "encoding", "setData", "layout", "replot", "blit", "total"};
+  const int STAGE_COUNT = int(sizeof(STAGES) / sizeof(STAGES[0]));
+
+  struct Percentile
+  {
+    const char* name;
+    double rank; // In percent
+  };
+
+  const Percentile PERCENTILES[] = {{"p50", 50}, {"p90", 90}, {"p99", 99}, {"max", 100}};
+
+  int fail(const QString& message)
+  {
+    fprintf(stderr, "%s: %s\n", qPrintable(QApplication::applicationName()), qPrintable(message));
+    return 1;
+  }
+
+  QString randomHex(qint64 digits, std::mt19937_64& random)
+  {
+    static const char DIGITS[] = "0123456789ABCDEF";
+    QString hex(int(digits), Qt::Uninitialized);
+    for (QChar& digit : hex)
+    {
+      digit = QLatin1Char(DIGITS[random() % 16]);
+    }
+    return hex;
+  }
+
+  // Nearest rank of sorted times
+  qint64 percentile(const QVector<qint64>& times, double rank)
+  {
+    const int index = int(std::ceil(rank / 100 * times.size())) - 1;
+    return times[qBound(0, index, times.size() - 1)];
+  }
+
+} // anonymous namespace end
+
+int main(int argc, char* argv[])
+{
+  if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+  { // The window is never shown on a display
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+  }
+  QApplication app(argc, argv);
+  QApplication::setApplicationName("binary-encoding-latency");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Times every stage from typing a message to its plots on screen.");
+  parser.addHelpOption();
+  const QCommandLineOption outputOption({"o", "output"}, "JSON results file, none when missing.", "file");
+  const QCommandLineOption iterationsOption({"n", "iterations"}, "Encodings timed per message size.",
+                                            "count", QString::number(DEFAULT_ITERATIONS));
+  const QCommandLineOption maxBitsOption("max-bits", "Largest message size.", "bits",
+                                         QString::number(DEFAULT_MAX_BITS));
+  const QCommandLineOption traceOption("trace",
+      "Chrome trace file every encoding is recorded to, it loads in chrome://tracing or Perfetto.",
+      "file");
+  parser.addOptions({outputOption, iterationsOption, maxBitsOption, traceOption});
+  parser.process(app);
+  const int iterations = qMax(1, parser.value(iterationsOption).toInt());
+  const qint64 maxBits = parser.value(maxBitsOption).toLongLong();
+
+  MainWindow window;
+  window.resize(WINDOW_WIDTH, WINDOW_HEIGHT);
+  window.show();
+  auto lineEdit = window.findChild<QLineEdit*>("messageLineEdit");
+  auto pushButton = window.findChild<QPushButton*>("pushButton");
+  auto liveCheckBox = window.findChild<QCheckBox*>("liveCheckBox");
+  auto plot = window.findChild<QCustomPlot*>("waveformPlot");
+  QList<QCheckBox*> methodCheckBoxes;
+  for (const char* name : METHOD_CHECK_BOXES)
+  {
+    methodCheckBoxes << window.findChild<QCheckBox*>(name);
+  }
+  if (!lineEdit || !pushButton || !liveCheckBox || !plot || methodCheckBoxes.contains(nullptr))
+  {
+    return fail("The main window lacks the widgets driven");
+  }
+  liveCheckBox->setChecked(false);
+  lineEdit->setMaxLength(INT_MAX); // Messages longer than the default 32767 digits
+  app.processEvents();
+  const QString traceFile = parser.value(traceOption);
+  if (!traceFile.isEmpty())
+  {
+    chrishenx::Tracer::start(traceFile);
+  }
+
+  // One encoding from the keystroke until the plots are painted, false on timeout
+  auto encode = [&](const QString& hex, QCheckBox* toggled, QVector<qint64>& times)
+  {
+    QElapsedTimer total;
+    total.start();
+    // Typed over the whole message, as a key event carrying every digit
+    lineEdit->setFocus();
+    lineEdit->selectAll();
+    QKeyEvent typing(QEvent::KeyPress, 0, Qt::NoModifier, hex);
+    QApplication::sendEvent(lineEdit, &typing);
+    toggled->click();
+
+    QEventLoop loop;
+    bool plotted = false;
+    MainWindow::StageTimes stageTimes;
+    const QMetaObject::Connection connection = QObject::connect(&window, &MainWindow::encodingPlotted,
+        [&](const MainWindow::StageTimes& plottedTimes)
+    {
+      stageTimes = plottedTimes;
+      plotted = true;
+      loop.quit();
+    });
+    QTimer::singleShot(FRAME_TIMEOUT, &loop, &QEventLoop::quit);
+    pushButton->click();
+    if (!plotted)
+    {
+      loop.exec();
+    }
+    QObject::disconnect(connection);
+    if (!plotted)
+    {
+      return false;
+    }
+    // The adopted render reaches the window on the next paint
+    QElapsedTimer paint;
+    paint.start();
+    plot->repaint();
+    stageTimes.blit += paint.nsecsElapsed();
+    times = {stageTimes.conversion, stageTimes.encoding, stageTimes.setData, stageTimes.layout,
+             stageTimes.replot, stageTimes.blit, total.nsecsElapsed()};
+    return true;
+  };
+
+  printf("%10s %-11s", "bits", "stage");
+  for (const Percentile& rank : PERCENTILES)
+  {
+    printf(" %9s ms", rank.name);
+  }
+  printf("\n");
+  std::mt19937_64 random(20151017); // The same messages on every run
+  QJsonArray resultArray;
+  int toggle = 0;
+  for (qint64 bits : SIZES)
+  {
+    if (bits > maxBits)
+    {
+      break;
+    }
+    QVector<QVector<qint64>> samples(STAGE_COUNT);
+    QVector<qint64> times;
+    for (int i = -1; i < iterations; ++i)
+    { // The first one warms up
+      const QString hex = randomHex(bits / 4, random);
+      QCheckBox* toggled = methodCheckBoxes[toggle++ % methodCheckBoxes.size()];
+      if (!encode(hex, toggled, times))
+      {
+        return fail(QString("Nothing was plotted for %1 bits within %2 s").arg(bits).arg(FRAME_TIMEOUT / 1000));
+      }
+      for (int stage = 0; i >= 0 && stage < STAGE_COUNT; ++stage)
+      {
+        samples[stage] << times[stage];
+      }
+    }
+
+    QJsonObject stageObject;
+    for (int stage = 0; stage < STAGE_COUNT; ++stage)
+    {
+      std::sort(samples[stage].begin(), samples[stage].end());
+      printf("%10lld %-11s", bits, STAGES[stage]);
+      QJsonObject percentileObject;
+      for (const Percentile& rank : PERCENTILES)
+      {
+        const qint64 time = percentile(samples[stage], rank.rank);
+        printf(" %12.3f", time / 1e6);
+        percentileObject.insert(rank.name, double(time));
+      }
+      printf("\n");
+      stageObject.insert(STAGES[stage], percentileObject);
+    }
+    resultArray << QJsonObject {{"bits", double(bits)}, {"stages", stageObject}};
+    fflush(stdout);
+  }
+
+  if (chrishenx::Tracer::isRecording() && !chrishenx::Tracer::stop())
+  {
+    return fail(QString("Cannot write %1: %2").arg(traceFile, chrishenx::Tracer::errorString()));
+  }
+  const QString fileName = parser.value(outputOption);
+  if (!fileName.isEmpty())
+  {
+    QFile output(fileName);
+    const QJsonObject description {
+      {"qtVersion", qVersion()},
+      {"iterations", iterations},
+      {"unit", "ns"},
+      {"results", resultArray}
+    };
+    if (!output.open(QIODevice::WriteOnly) || output.write(QJsonDocument(description).toJson()) < 0)
+    {
+      return fail(output.errorString());
+    }
+  }
+  return 0;
+}
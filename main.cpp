@@ -1,4 +1,5 @@
 #include "mainwindow.h"
+#include "tracing.h"
 #include <QApplication>
 
 int main(int argc, char *argv[])
@@ -7,8 +8,16 @@ int main(int argc, char *argv[])
 
     a.setStyle("fusion");
 
+    // BINARY_ENCODING_TRACE names a Chrome trace file to record the whole session to
+    const QString traceFile = QString::fromLocal8Bit(qgetenv("BINARY_ENCODING_TRACE"));
+    if (!traceFile.isEmpty())
+        chrishenx::Tracer::start(traceFile);
+
     MainWindow w;
     w.show();
 
-    return a.exec();
+    const int status = a.exec();
+    if (chrishenx::Tracer::isRecording() && !chrishenx::Tracer::stop())
+        qWarning("Cannot write %s: %s", qPrintable(traceFile), qPrintable(chrishenx::Tracer::errorString()));
+    return status;
 }
@@ -2,25 +2,85 @@
 #include "ui_mainwindow.h"
 
 #include "binaryencoder.h"
+#include "bitticker.h"
+#include "capturefile.h"
+#include "encodingjob.h"
+#include "hexconversion.h"
+#include "tracing.h"
+#include "waveformfile.h"
+#include "waveformtiles.h"
+#include "waveformvector.h"
+#include "waveformwriter.h"
 
 #include <QCheckBox>
+#include <QInputMethodEvent>
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include <QLabel>
+#include <QRadioButton>
+#include <QSaveFile>
+#include <QElapsedTimer>
+#include <QFileDialog>
+#include <QInputDialog>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 #include <QDebug> // TODO Delete qDebug and its references when the project is ready
 
 using namespace chrishenx;
 
-static QString hex2bin(const QString& hex);
+const double MainWindow::WHEEL_ZOOM_FACTOR = 0.85; // The one of QCustomPlot's own zoom
+
+namespace {
+
+  // Writes fileName through write, which returns what went wrong or nothing, replacing the file
+  // only once all of it was written
+  QString saveFile(const QString& fileName, std::function<QString(QSaveFile& file)> write)
+  {
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+      return file.errorString();
+    }
+    const QString error = write(file);
+    if (!error.isEmpty())
+    {
+      return error;
+    }
+    return file.commit() ? QString() : file.errorString();
+  }
+
+} // anonymous namespace end
 
 MainWindow::MainWindow(QWidget *parent) :
   QMainWindow(parent),
-  ui(new Ui::MainWindow)
+  ui(new Ui::MainWindow),
+  encodingJob(new EncodingJob(this))
 {
   ui->setupUi(this);
 
   message = "";
 
   configureLineEditFonts();
+  configureEditTracking();
+  ui->binaryMessageView->setBitBuffer(&messageBits);
   configureMethodCheckBoxes();
-  configureCustomPlots();
+  configureWaveformPlot();
+  configureLiveMode();
+
+  connect(&renderWatcher, &QFutureWatcher<RenderedPlot>::finished, this, &MainWindow::renderFinished);
+  // Emitted by the pool threads, queued onto this one
+  connect(encodingJob, &EncodingJob::progressChanged, this, [this](int percent)
+  {
+    if (encodingJob->isRunning() && !ui->liveCheckBox->isChecked())
+    {
+      ui->statusBar->showMessage(QString("Codificando... %1%").arg(percent));
+    }
+  });
 
 #ifdef Q_OS_ANDROID
 
@@ -51,26 +111,17 @@ void MainWindow::configureMethodCheckBoxes()
     {
       if (!toggled)
       {
-          // Branch 1
-          if (selectedCheckBoxes.contains(checkBox))
-          {
-              selectedCheckBoxes.removeOne(checkBox);
-          }
+        selectedCheckBoxes.removeOne(checkBox);
       }
       else
       {
-          // Branch 2
-          if (selectedCheckBoxes.size() == ALLOWED_METHODS_CHECKED)
-          {
-              selectedCheckBoxes.front()->setChecked(false);
-              // Executing Branch 1 concurrently on another QCheckBox
-          }
-          selectedCheckBoxes << checkBox;
+        selectedCheckBoxes << checkBox;
       }
       if (checkBox == ui->mlevel_checkBox)
       {
         ui->levelsGroupBox->setEnabled(toggled);
       }
+      scheduleLivePlot();
     });
   }
   ui->ttl_checkBox->click();
@@ -78,211 +129,999 @@ void MainWindow::configureMethodCheckBoxes()
   ui->nrzl_checkBox->click();
 }
 
+void MainWindow::configureLiveMode()
+{
+  // Edits closer than the debounce interval are encoded once, a newer edit cancels the encoding
+  // in flight and the replots are coalesced by stagePlotChange()
+  liveTimer.setSingleShot(true);
+  liveTimer.setInterval(LIVE_DEBOUNCE_INTERVAL);
+  connect(&liveTimer, &QTimer::timeout, [this]()
+  {
+    if (!messageBits.isEmpty())
+    {
+      plotSelectedMethods();
+    }
+    else
+    {
+      // Nothing left to encode, an encoding still in flight is dropped and the plot emptied
+      liveLatency.invalidate();
+      encodingJob->cancel();
+      waveformFile.reset();
+      stagePlotChange(ui->waveformPlot, [this]()
+      {
+        setTraceCount(1);
+        replaceTraceData(0, new QCPDataMap);
+        if (traces.first().capture)
+        {
+          traces.first().capture->data()->clear();
+        }
+      });
+    }
+  });
+  for (QRadioButton* radioButton : {ui->l2radioButton, ui->l4radioButton, ui->l8radioButton})
+  {
+    connect(radioButton, &QRadioButton::toggled, [this](bool toggled)
+    {
+      if (toggled && ui->mlevel_checkBox->isChecked())
+      {
+        scheduleLivePlot();
+      }
+    });
+  }
+  latencyLabel = new QLabel(this);
+  latencyLabel->setToolTip("Desde la edición hasta que la gráfica está dibujada");
+  latencyLabel->hide();
+  ui->statusBar->addPermanentWidget(latencyLabel);
+  connect(ui->liveCheckBox, &QCheckBox::toggled, [this](bool toggled)
+  {
+    latencyLabel->setVisible(toggled);
+    if (toggled)
+    {
+      ui->pushButton->setText("Codificar");
+      scheduleLivePlot();
+    }
+  });
+}
+
+void MainWindow::scheduleLivePlot()
+{
+  if (!ui->liveCheckBox->isChecked())
+  {
+    return;
+  }
+  encodingJob->cancel();
+  if (!liveLatency.isValid())
+  { // Measured from the oldest edit not on screen yet
+    liveLatency.start();
+  }
+  liveTimer.start();
+}
+
 void MainWindow::configureLineEditFonts()
 {
   QFont spacedFont = ui->messageLineEdit->font();
   spacedFont.setLetterSpacing(QFont::AbsoluteSpacing, 10);
+  spacedFont.setCapitalization(QFont::AllUppercase); // Cheaper than rewriting the text on every edit
   ui->messageLineEdit->setFont(spacedFont);
-  spacedFont = ui->binaryMessageLineEdit->font();
-  spacedFont.setLetterSpacing(QFont::AbsoluteSpacing, 8);
-  ui->binaryMessageLineEdit->setFont(spacedFont);
 }
 
-void MainWindow::configureCustomPlots()
+void MainWindow::configureEditTracking()
 {
-  ui->clockPlot->plotLayout()->insertRow(0);
-  ui->clockPlot->plotLayout()->addElement(0, 0, new QCPPlotTitle(ui->clockPlot, "Señal de reloj"));
-  ui->clockPlot->setToolTip("Señal de reloj");
-  QCPPlotTitle* plotTitle = (QCPPlotTitle*) ui->clockPlot->plotLayout()->element(0, 0);
-  QFont titleFont = plotTitle->font();
-  titleFont.setPointSize(11);
-  plotTitle->setFont(titleFont);
-  customPlots << ui->clockPlot
-              << ui->cod1Plot
-              << ui->cod2Plot
-              << ui->cod3Plot;
-  for (QCustomPlot* customPlot : customPlots)
-  {
-    QCPGraph* graph = customPlot->addGraph(0);
-    QPen pen = graph->pen();
-    pen.setWidthF(3.5);
-    if (customPlot == ui->clockPlot)
-    {
-      pen.setColor(QColor(Qt::red));
+  // textEdited is emitted before these, so they still describe the text before the edit
+  connect(ui->messageLineEdit, &QLineEdit::cursorPositionChanged, [this](int, int position)
+  {
+    editCursor = position;
+  });
+  connect(ui->messageLineEdit, &QLineEdit::selectionChanged, [this]()
+  {
+    editSelectionStart = ui->messageLineEdit->selectionStart();
+    editSelectionLength = ui->messageLineEdit->selectedText().length();
+  });
+  ui->messageLineEdit->installEventFilter(this);
+}
+
+bool MainWindow::eventFilter(QObject* watched, QEvent* event)
+{
+  if (watched == ui->messageLineEdit)
+  {
+    // Edits whose position can not be told from the cursor, input method commits may also replace
+    // text around it
+    QKeyEvent* keyEvent = event->type() == QEvent::KeyPress ? static_cast<QKeyEvent*>(event) : nullptr;
+    QInputMethodEvent* inputMethodEvent = event->type() == QEvent::InputMethod ?
+                                          static_cast<QInputMethodEvent*>(event) : nullptr;
+    if ((keyEvent && (keyEvent->matches(QKeySequence::Undo) || keyEvent->matches(QKeySequence::Redo))) ||
+        (inputMethodEvent && (inputMethodEvent->replacementStart() != 0 ||
+                              inputMethodEvent->replacementLength() != 0)) ||
+        event->type() == QEvent::ContextMenu || event->type() == QEvent::Drop)
+    {
+      editTracked = false;
     }
-    else
+  }
+  else if (watched == ui->waveformPlot && navigateWaveforms(event))
+  {
+    return true;
+  }
+  return QMainWindow::eventFilter(watched, event);
+}
+
+bool MainWindow::navigateWaveforms(QEvent* event)
+{
+  // QCustomPlot's own dragging and zooming would set the axes while a render on the thread pool
+  // draws them, the moves are staged like any other plot change instead. Dragging or zooming any
+  // trace moves the clock axis, which the other traces and the paging follow
+  QCustomPlot* plot = ui->waveformPlot;
+  QCPAxis* clockAxis = traces.first().axisRect->axis(QCPAxis::atBottom);
+  auto overTrace = [this](const QPoint& position)
+  {
+    return std::any_of(traces.constBegin(), traces.constEnd(), [&](const Trace& trace)
     {
-      customPlot->plotLayout()->insertRow(0);
-      customPlot->plotLayout()->addElement(0, 0, new QCPPlotTitle(customPlot, " "));
-      plotTitle = (QCPPlotTitle*) customPlot->plotLayout()->element(0, 0);
-      titleFont = plotTitle->font();
-      titleFont.setPointSize(11);
-      plotTitle->setFont(titleFont);
+      return trace.axisRect->rect().contains(position);
+    });
+  };
+  switch (event->type())
+  {
+  case QEvent::MouseButtonPress:
+  {
+    const QMouseEvent* mouseEvent = static_cast<QMouseEvent*>(event);
+    if (mouseEvent->button() != Qt::LeftButton || !overTrace(mouseEvent->pos()))
+    {
+      return false;
+    }
+    panning = true;
+    panX = mouseEvent->pos().x();
+    return true;
+  }
+  case QEvent::MouseMove:
+  {
+    if (!panning)
+    {
+      return false;
     }
-    graph->setPen(pen);
+    const int from = panX;
+    const int to = static_cast<QMouseEvent*>(event)->pos().x();
+    panX = to;
+    stagePlotChange(plot, [=]()
+    {
+      clockAxis->moveRange(clockAxis->pixelToCoord(from) - clockAxis->pixelToCoord(to));
+    });
+    return true;
+  }
+  case QEvent::MouseButtonRelease:
+    if (!panning)
+    {
+      return false;
+    }
+    panning = false;
+    return true;
+  case QEvent::Wheel:
+  {
+    const QWheelEvent* wheelEvent = static_cast<QWheelEvent*>(event);
+    if (!overTrace(wheelEvent->pos()))
+    {
+      return false;
+    }
+    const double factor = std::pow(WHEEL_ZOOM_FACTOR, wheelEvent->angleDelta().y() / 120.0);
+    const int x = wheelEvent->pos().x();
+    stagePlotChange(plot, [=]()
+    {
+      clockAxis->scaleRange(factor, clockAxis->pixelToCoord(x));
+    });
+    return true;
+  }
+  default:
+    return false;
+  }
+}
+
+bool MainWindow::locateEdit(const QString& input, qint64& start, qint64& removed, qint64& inserted) const
+{
+  if (!editTracked)
+  {
+    return false;
+  }
+  // The text after the cursor is untouched, the edit begins at the selection or at the cursor
+  const qint64 cursor = ui->messageLineEdit->cursorPosition();
+  start = editSelectionStart != -1 && editSelectionLength > 0 ? editSelectionStart : qMin(editCursor, int(cursor));
+  const qint64 suffix = input.length() - cursor;
+  removed = message.length() - start - suffix;
+  inserted = cursor - start;
+  return start >= 0 && removed >= 0 && inserted >= 0 && start + removed <= message.length();
+}
+
+void MainWindow::configureWaveformPlot()
+{
+  // The default axis rect holds the clock, every other trace is stacked below it
+  QCustomPlot* plot = ui->waveformPlot;
+  marginGroup = new QCPMarginGroup(plot);
+  plot->plotLayout()->insertRow(0);
+  Trace clock;
+  clock.title = new QCPPlotTitle(plot, "Señal de reloj");
+  clock.axisRect = plot->axisRect(0);
+  clock.graph = plot->addGraph(0);
+  plot->plotLayout()->addElement(0, 0, clock.title);
+  configureTrace(clock);
+  traces << clock;
+  QPen pen = clock.graph->pen();
+  pen.setColor(QColor(Qt::red));
+  clock.graph->setPen(pen);
+  plot->setMinimumHeight(TRACE_HEIGHT);
+  plot->installEventFilter(this); // Dragging and zooming the traces
+  // An opened file is read only as far as the plots show
+  connect(clock.axisRect->axis(QCPAxis::atBottom),
+          static_cast<void (QCPAxis::*)(const QCPRange&)>(&QCPAxis::rangeChanged),
+          [this]() { pageWaveforms(); });
+}
+
+void MainWindow::configureTrace(Trace& trace)
+{
+  trace.ticker = new BitTicker(trace.axisRect->axis(QCPAxis::atBottom));
+  QFont titleFont = trace.title->font();
+  titleFont.setPointSize(11);
+  trace.title->setFont(titleFont);
+  trace.axisRect->setMarginGroup(QCP::msLeft | QCP::msRight, marginGroup);
+  QPen pen = trace.graph->pen();
+  pen.setWidthF(3.5);
+  trace.graph->setPen(pen);
 
 #ifdef Q_OS_ANDROID
-    QFont labelFont = customPlot->yAxis->tickLabelFont();
-    labelFont.setPointSize(6);
-    customPlot->yAxis->setTickLabelFont(labelFont);
-    customPlot->xAxis->setTickLabelFont(labelFont);
+  QFont labelFont = trace.axisRect->axis(QCPAxis::atLeft)->tickLabelFont();
+  labelFont.setPointSize(6);
+  trace.axisRect->axis(QCPAxis::atLeft)->setTickLabelFont(labelFont);
+  trace.axisRect->axis(QCPAxis::atBottom)->setTickLabelFont(labelFont);
 #endif
 
-  }
-  customPlots.pop_front(); // Deleting clockPlot
 }
 
-static bool isHexadecimal(const QString& value)
+void MainWindow::setTraceCount(int count)
 {
-  static const QString hexadecimalSymbols = "0123456789ABCDEF";
-  for (const QChar& symbol : value)
+  QCustomPlot* plot = ui->waveformPlot;
+  QCPAxis* clockAxis = traces.first().axisRect->axis(QCPAxis::atBottom);
+  while (traces.size() < count)
+  {
+    const int row = traces.size() * 2;
+    Trace trace;
+    trace.title = new QCPPlotTitle(plot, " ");
+    trace.axisRect = new QCPAxisRect(plot);
+    plot->plotLayout()->addElement(row, 0, trace.title);
+    plot->plotLayout()->addElement(row + 1, 0, trace.axisRect);
+    trace.graph = plot->addGraph(trace.axisRect->axis(QCPAxis::atBottom),
+                                 trace.axisRect->axis(QCPAxis::atLeft));
+    // Every trace follows the x range of the clock
+    connect(clockAxis, SIGNAL(rangeChanged(QCPRange)),
+            trace.axisRect->axis(QCPAxis::atBottom), SLOT(setRange(QCPRange)));
+    configureTrace(trace);
+    traces << trace;
+  }
+  while (traces.size() > qMax(count, 1))
   {
-    if (!hexadecimalSymbols.contains(symbol, Qt::CaseInsensitive))
+    const Trace trace = traces.takeLast();
+    plot->removeGraph(trace.graph);
+    if (trace.capture)
     {
-      return false;
+      plot->removeGraph(trace.capture);
     }
+    plot->plotLayout()->remove(trace.title);
+    plot->plotLayout()->remove(trace.axisRect);
   }
-  return true;
+  plot->plotLayout()->simplify();
+  plot->setMinimumHeight(TRACE_HEIGHT * traces.size());
 }
 
 void MainWindow::on_messageLineEdit_textEdited(const QString &input)
 {
-  if (input.isEmpty())
+  // Only the edited digits are validated and converted
+  QElapsedTimer conversionTimer;
+  conversionTimer.start();
+  qint64 start, removed, inserted;
+  if (!locateEdit(input, start, removed, inserted))
   {
-    message = "";
-    ui->binaryMessageLineEdit->setText(message);
+    start = 0;
+    removed = message.length();
+    inserted = input.length();
+  }
+  editTracked = true;
+  const QString insertedDigits = input.mid(int(start), int(inserted));
+  const qint64 invalidPosition = firstInvalidHexDigit(insertedDigits);
+  if (invalidPosition != -1)
+  {
+    // Pointing at the offending character, where the line edit puts a cursor before it. The cursor
+    // rectangle is only public through the input method query
+    ui->messageLineEdit->setCursorPosition(int(start + invalidPosition));
+    const QRect cursor = ui->messageLineEdit->inputMethodQuery(Qt::ImCursorRectangle).toRect();
+    QToolTip::showText(ui->messageLineEdit->mapToGlobal(QPoint(qMax(cursor.left(), 0), 0)),
+                       QString("Solo digitos hexadecimales! (posición %1)").arg(start + invalidPosition + 1));
+    ui->messageLineEdit->setText(message);
+    ui->messageLineEdit->setCursorPosition(int(start));
+    return;
+  }
+  QToolTip::hideText();
+  message = input;
+  if (encodingJob->isRunning() && !ui->liveCheckBox->isChecked())
+  {
+    stopEncoding("Codificación cancelada, el mensaje cambió.");
+  }
+  messageBits.replace(start * 4, removed * 4, hexToBits(insertedDigits));
+  stageTimes.conversion += conversionTimer.nsecsElapsed();
+  ui->binaryMessageView->bitsChanged(start * 4);
+  scheduleLivePlot();
+}
+
+void MainWindow::on_pushButton_clicked()
+{
+  if (encodingJob->isRunning())
+  {
+    stopEncoding("Codificación cancelada.");
+  }
+  else if (messageBits.isEmpty())
+  {
+    ui->statusBar->showMessage("Introduce tu mensage.", STATUS_BAR_MESSAGE_DURATION);
   }
   else
   {
-    if (!isHexadecimal(input))
+    plotSelectedMethods();
+  }
+}
+
+void MainWindow::stopEncoding(const QString& statusMessage)
+{
+  encodingJob->cancel();
+  ui->pushButton->setText("Codificar");
+  ui->statusBar->showMessage(statusMessage, STATUS_BAR_MESSAGE_DURATION);
+}
+
+QVector<WaveformTrack> MainWindow::selectedTraces() const
+{
+  // The reference clock signal goes first
+  QVector<WaveformTrack> selected;
+  selected << WaveformTrack { BinaryEncoder::Method::CLOCK, BinaryEncoder::DEFAULT_LEVELS };
+  for (const QCheckBox* selectedCheckBox : selectedCheckBoxes)
+  {
+    WaveformTrack trace { BinaryEncoder::Method::TTL, BinaryEncoder::DEFAULT_LEVELS };
+    if (selectedCheckBox == ui->nrzl_checkBox)
     {
-      QToolTip::showText(ui->messageLineEdit->mapToGlobal(QPoint(0, 0)),
-                         "Solo digitos hexadecimales!");
-      ui->messageLineEdit->setText(message);
+      trace.method = BinaryEncoder::Method::NRZL;
     }
-    else
+    else if (selectedCheckBox == ui->nrzi_checkBox)
     {
-      message = input.toUpper();
-      QToolTip::hideText();
+      trace.method = BinaryEncoder::Method::NRZI;
     }
-    ui->messageLineEdit->setText(message);
-    ui->binaryMessageLineEdit->setText(hex2bin(message));
+    else if (selectedCheckBox == ui->bip_checkBox)
+    {
+      trace.method = BinaryEncoder::Method::BIPOLAR;
+    }
+    else if (selectedCheckBox == ui->pset_checkBox)
+    {
+      trace.method = BinaryEncoder::Method::PSEUDOTERNARY;
+    }
+    else if (selectedCheckBox == ui->manch_checkBox)
+    {
+      trace.method = BinaryEncoder::Method::MANCHESTER;
+    }
+    else if (selectedCheckBox == ui->manchd_checkBox)
+    {
+      trace.method = BinaryEncoder::Method::DMANCHESTER;
+    }
+    else if (selectedCheckBox == ui->mlevel_checkBox)
+    {
+      trace.method = BinaryEncoder::Method::MULTILEVEL;
+      trace.levels = ui->l2radioButton->isChecked() ? 2 :
+                     ui->l4radioButton->isChecked() ? 4 : 8;
+    }
+    selected << trace;
   }
+  return selected;
 }
 
-void MainWindow::on_pushButton_clicked()
+static QString traceTitle(const WaveformTrack& trace)
 {
-  if (selectedCheckBoxes.size() > ALLOWED_METHODS_CHECKED)
-  { // TODO Delete this brach since never happens
-    ui->statusBar->showMessage("Selecciona 3 métodos.", STATUS_BAR_MESSAGE_DURATION);
+  switch (trace.method)
+  {
+  case BinaryEncoder::Method::CLOCK:
+    return "Señal de reloj";
+  case BinaryEncoder::Method::TTL:
+    return "Codificación TTL";
+  case BinaryEncoder::Method::NRZL:
+    return "Codificación NRZ-L";
+  case BinaryEncoder::Method::NRZI:
+    return "Codificación NRZ-I";
+  case BinaryEncoder::Method::BIPOLAR:
+    return "Codificación Bipolar";
+  case BinaryEncoder::Method::PSEUDOTERNARY:
+    return "Codificación Pseudo-ternaria";
+  case BinaryEncoder::Method::MANCHESTER:
+    return "Codificación Manchester";
+  case BinaryEncoder::Method::DMANCHESTER:
+    return "Codificación Manchester diferencial";
+  case BinaryEncoder::Method::MULTILEVEL:
+    return QString("Codificación de %1 niveles").arg(trace.levels);
   }
-  else
+  return QString();
+}
+
+void MainWindow::layoutTraces(const QVector<WaveformTrack>& kinds, double amplitude, double bitPeriod,
+                              qint64 bitCount)
+{
+  static const double ZERO_LOWER = -0.09;
+  const double SIGNAL_AMPLITUDE = amplitude * 1.08;
+  setTraceCount(kinds.size());
+  for (int i = 0; i < kinds.size(); ++i)
   {
-    QString message = ui->binaryMessageLineEdit->text();
-    if (message.isEmpty())
+    const Trace& trace = traces[i];
+    const bool unipolar = kinds[i].method == BinaryEncoder::Method::CLOCK ||
+                          kinds[i].method == BinaryEncoder::Method::TTL;
+    trace.axisRect->axis(QCPAxis::atLeft)->setRange(unipolar ? ZERO_LOWER : -SIGNAL_AMPLITUDE, SIGNAL_AMPLITUDE);
+    trace.axisRect->axis(QCPAxis::atBottom)->setRange(0, bitCount * bitPeriod);
+    trace.ticker->setBitPeriod(bitPeriod);
+    trace.ticker->setBitCount(bitCount);
+    trace.title->setText(traceTitle(kinds[i]));
+  }
+}
+
+void MainWindow::replaceTraceData(int index, QCPDataMap* data)
+{
+  TraceScope traceScope("MainWindow::replaceTraceData"); // The setData stage
+  traces[index].graph->data()->swap(*data);
+  // The replaced points can be many, they are freed away from the GUI thread
+  QtConcurrent::run([data]() { delete data; });
+}
+
+void MainWindow::plotSelectedMethods()
+{
+  waveformFile.reset();
+  const QVector<WaveformTrack> kinds = selectedTraces();
+  const BinaryEncoder binaryEncoder(messageBits);
+  const double amplitude = binaryEncoder.amplitude();
+  const double bitPeriod = binaryEncoder.currentPeriod();
+  const qint64 bitCount = binaryEncoder.bitCount();
+  const bool live = ui->liveCheckBox->isChecked();
+
+  // The points are generated on the thread pool, only a finished and still current result gets
+  // staged. Its maps are swapped into the graphs, so the GUI thread never copies any point
+  QElapsedTimer encodingTimer;
+  encodingTimer.start();
+  auto watcher = new QFutureWatcher<EncodingJob::Result>(this);
+  connect(watcher, &QFutureWatcherBase::finished, [=]()
+  {
+    const EncodingJob::Result result = watcher->result();
+    const qint64 encodingTime = encodingTimer.nsecsElapsed();
+    watcher->deleteLater();
+    if (!encodingJob->isCurrent(result))
     {
-      ui->statusBar->showMessage("Introduce tu mensage.", STATUS_BAR_MESSAGE_DURATION);
+      qDeleteAll(result.data);
+      return;
     }
-    else
+    if (!live)
     {
-      // All QCUstomPlots' graphs most exist at this point
-      clearPlots();
-      plotSelectedMethods();
+      ui->pushButton->setText("Codificar");
+      ui->statusBar->clearMessage();
     }
+    stagePlotChange(ui->waveformPlot, [=]()
+    {
+      liveFrameRendering = live;
+      encodingRendering = true;
+      stageTimes.encoding = encodingTime;
+      QElapsedTimer timer;
+      timer.start();
+      layoutTraces(kinds, amplitude, bitPeriod, bitCount);
+      stageTimes.layout = timer.nsecsElapsed();
+      timer.restart();
+      for (int i = 0; i < kinds.size(); ++i)
+      {
+        replaceTraceData(i, result.data[i]);
+      }
+      stageTimes.setData = timer.nsecsElapsed();
+    });
+  });
+  watcher->setFuture(encodingJob->start(messageBits, kinds));
+  if (!live)
+  {
+    ui->pushButton->setText("Cancelar");
+    ui->statusBar->showMessage("Codificando...");
   }
 }
 
-void MainWindow::plotSelectedMethods()
+bool MainWindow::checkMessage()
 {
-  BinaryEncoder binaryEncoder(ui->binaryMessageLineEdit->text());
+  if (messageBits.isEmpty())
+  {
+    ui->statusBar->showMessage("Introduce tu mensage.", STATUS_BAR_MESSAGE_DURATION);
+    return false;
+  }
+  return true;
+}
 
-  static const double ZERO_LOWER = -0.09;
-  const double SIGNAL_AMPLITUDE = binaryEncoder.amplitude() * 1.08;
-  const int MSG_LENGHT = binaryEncoder.messageLength();
-
-  // Ploting the reference clock signal
-  ui->clockPlot->graph(0)->setData(binaryEncoder.generateClock());
-  ui->clockPlot->xAxis->setRange(0, binaryEncoder.timeMax());
-  ui->clockPlot->yAxis->setRange(ZERO_LOWER, SIGNAL_AMPLITUDE);
-  ui->clockPlot->xAxis->setAutoTickCount(MSG_LENGHT - 1);
-  ui->clockPlot->replot();
-  auto customPlotIt = customPlots.begin();
-  for (const QCheckBox* selectedCheckBox : selectedCheckBoxes)
+void MainWindow::runExport(const QString& target, std::function<QString()> task, bool saving)
+{
+  auto watcher = new QFutureWatcher<QString>(this);
+  connect(watcher, &QFutureWatcherBase::finished, [=]()
   {
-    QCustomPlot* customPlot = *customPlotIt;
-    QCPPlotTitle* plotTitle = (QCPPlotTitle*) customPlot->plotLayout()->element(0, 0);
-    if (selectedCheckBox == ui->ttl_checkBox)
+    const QString error = watcher->result();
+    watcher->deleteLater();
+    if (saving)
     {
-      customPlot->graph(0)->setData(binaryEncoder.generateTTL());
-      customPlot->yAxis->setRange(ZERO_LOWER, SIGNAL_AMPLITUDE);
-      customPlot->setToolTip("Codificación TTL");
-      plotTitle->setText("Codificación TTL");
+      ui->statusBar->showMessage(error.isEmpty() ? QString("Guardado en %1").arg(target)
+                                                 : QString("No se pudo guardar: %1").arg(error),
+                                 STATUS_BAR_MESSAGE_DURATION);
     }
-    else if (selectedCheckBox == ui->nrzl_checkBox)
+    else
     {
-      customPlot->graph(0)->setData(binaryEncoder.generateNRZL());
-      customPlot->yAxis->setRange(-SIGNAL_AMPLITUDE, SIGNAL_AMPLITUDE);
-      customPlot->setToolTip("Codificación NRZ-L");
-      plotTitle->setText("Codificación NRZ-L");
+      ui->statusBar->showMessage(error.isEmpty() ? QString("Exportado a %1").arg(target)
+                                                 : QString("No se pudo exportar: %1").arg(error),
+                                 STATUS_BAR_MESSAGE_DURATION);
     }
-    else if (selectedCheckBox == ui->nrzi_checkBox)
+  });
+  watcher->setFuture(QtConcurrent::run(task));
+  ui->statusBar->showMessage(saving ? "Guardando..." : "Exportando...");
+}
+
+void MainWindow::on_actionSaveWaveforms_triggered()
+{
+  if (!checkMessage())
+  {
+    return;
+  }
+  const QString fileName = QFileDialog::getSaveFileName(this, "Guardar codificación", QString(),
+                                                        "Formas de onda (*.bew)");
+  if (fileName.isEmpty())
+  {
+    return;
+  }
+  // Encoded again chunk by chunk while written, nothing but the message is kept for it
+  const BitBuffer bits = messageBits;
+  const QVector<WaveformTrack> kinds = selectedTraces();
+  runExport(fileName, [=]()
+  {
+    return saveFile(fileName, [&](QSaveFile& file)
+    {
+      return writeWaveformFile(&file, bits, BinaryEncoder::DEFAULT_TRANS_SPEED, BinaryEncoder::DEFAULT_AMPLITUDE,
+                               kinds) ? QString() : file.errorString();
+    });
+  }, true);
+}
+
+void MainWindow::on_actionExportAudio_triggered()
+{
+  if (!checkMessage())
+  {
+    return;
+  }
+  const QString wavInt = "WAV de 16 bits (*.wav)";
+  const QString wavFloat = "WAV de 32 bits flotante (*.wav)";
+  const QString rawInt = "PCM de 16 bits sin cabecera (*.pcm *.raw)";
+  const QString rawFloat = "PCM de 32 bits flotante sin cabecera (*.f32 *.raw)";
+  QString filter = wavInt;
+  const QString fileName = QFileDialog::getSaveFileName(this, "Exportar audio", QString(),
+                                                        QStringList({wavInt, wavFloat, rawInt, rawFloat}).join(";;"),
+                                                        &filter);
+  if (fileName.isEmpty())
+  {
+    return;
+  }
+  bool accepted;
+  const int sampleRate = QInputDialog::getInt(this, "Exportar audio", "Frecuencia de muestreo (Hz):",
+                                              DEFAULT_SAMPLE_RATE, 1, 1000000000, 1, &accepted);
+  if (!accepted)
+  {
+    return;
+  }
+  // A method per channel, rendered and written block by block while encoded again
+  const SampleFormat format = filter == wavInt || filter == rawInt ? SampleFormat::INT16 : SampleFormat::FLOAT32;
+  const bool wav = filter == wavInt || filter == wavFloat;
+  const BitBuffer bits = messageBits;
+  const QVector<WaveformTrack> kinds = selectedTraces();
+  runExport(fileName, [=]()
+  {
+    return saveFile(fileName, [&](QSaveFile& file)
+    {
+      BinaryEncoder encoder(bits, BinaryEncoder::DEFAULT_TRANS_SPEED, BinaryEncoder::DEFAULT_AMPLITUDE);
+      return writeAudio(&file, encoder, kinds, sampleRate, format, wav) ? QString() : file.errorString();
+    });
+  });
+}
+
+void MainWindow::on_actionExportTable_triggered()
+{
+  if (!checkMessage())
+  {
+    return;
+  }
+  const QString csvPoints = "CSV con todos los vértices (*.csv)";
+  const QString csvEdges = "CSV solo con los flancos (*.csv)";
+  const QString tsvPoints = "TSV con todos los vértices (*.tsv)";
+  const QString tsvEdges = "TSV solo con los flancos (*.tsv)";
+  QString filter = csvPoints;
+  const QString fileName = QFileDialog::getSaveFileName(this, "Exportar tabla", QString(),
+                                                        QStringList({csvPoints, csvEdges, tsvPoints, tsvEdges}).join(";;"),
+                                                        &filter);
+  if (fileName.isEmpty())
+  {
+    return;
+  }
+  // The chunks are formatted on the thread pool and written in order by the task
+  const char separator = filter == tsvPoints || filter == tsvEdges ? '\t' : ',';
+  const bool edgesOnly = filter == csvEdges || filter == tsvEdges;
+  const BitBuffer bits = messageBits;
+  const QVector<WaveformTrack> kinds = selectedTraces();
+  QList<QByteArray> labels;
+  for (const WaveformTrack& kind : kinds)
+  {
+    labels << traceTitle(kind).toUtf8();
+  }
+  runExport(fileName, [=]()
+  {
+    return saveFile(fileName, [&](QSaveFile& file)
+    {
+      BinaryEncoder encoder(bits, BinaryEncoder::DEFAULT_TRANS_SPEED, BinaryEncoder::DEFAULT_AMPLITUDE);
+      return writeCsv(&file, encoder, kinds, labels, separator, edgesOnly) ? QString() : file.errorString();
+    });
+  });
+}
+
+void MainWindow::on_actionExportImage_triggered()
+{
+  if (!checkMessage())
+  {
+    return;
+  }
+  const QString directory = QFileDialog::getExistingDirectory(this, "Exportar imagen");
+  if (directory.isEmpty())
+  {
+    return;
+  }
+  bool accepted;
+  const int width = QInputDialog::getInt(this, "Exportar imagen", "Ancho de la imagen (px):",
+                                         int(qMin<qint64>(qint64(messageBits.size()) * DEFAULT_BIT_WIDTH,
+                                                          std::numeric_limits<int>::max())),
+                                         1, std::numeric_limits<int>::max(), 1, &accepted);
+  if (!accepted)
+  {
+    return;
+  }
+  // The tiles are rendered on the thread pool by the task, never the whole image at once
+  const BitBuffer bits = messageBits;
+  const QVector<WaveformTrack> kinds = selectedTraces();
+  QStringList titles;
+  for (const WaveformTrack& kind : kinds)
+  {
+    titles << traceTitle(kind);
+  }
+  runExport(directory, [=]()
+  {
+    WaveformTileWriter writer(bits, BinaryEncoder::DEFAULT_TRANS_SPEED, BinaryEncoder::DEFAULT_AMPLITUDE);
+    return writer.write(directory, width, kinds, titles) ? QString() : writer.errorString();
+  });
+}
+
+void MainWindow::on_actionExportFigure_triggered()
+{
+  if (!checkMessage())
+  {
+    return;
+  }
+  const QString svg = "Figura SVG (*.svg)";
+  const QString pdf = "Documento PDF (*.pdf)";
+  QString filter = svg;
+  const QString fileName = QFileDialog::getSaveFileName(this, "Exportar figura", QString(),
+                                                        QStringList({svg, pdf}).join(";;"), &filter);
+  if (fileName.isEmpty())
+  {
+    return;
+  }
+  bool accepted;
+  const int width = QInputDialog::getInt(this, "Exportar figura", "Ancho de la figura (px):",
+                                         int(qMin<qint64>(qint64(messageBits.size()) * DEFAULT_BIT_WIDTH,
+                                                          std::numeric_limits<int>::max())),
+                                         1, std::numeric_limits<int>::max(), 1, &accepted);
+  if (!accepted)
+  {
+    return;
+  }
+  // The paths are simplified for the width, so only what can be seen is written
+  const bool asPdf = filter == pdf;
+  const BitBuffer bits = messageBits;
+  const QVector<WaveformTrack> kinds = selectedTraces();
+  QStringList titles;
+  for (const WaveformTrack& kind : kinds)
+  {
+    titles << traceTitle(kind);
+  }
+  runExport(fileName, [=]()
+  {
+    return saveFile(fileName, [&](QSaveFile& file)
+    {
+      WaveformVectorWriter writer(bits, BinaryEncoder::DEFAULT_TRANS_SPEED, BinaryEncoder::DEFAULT_AMPLITUDE);
+      const bool written = asPdf ? writer.writePdf(&file, width, kinds, titles)
+                                 : writer.writeSvg(&file, width, kinds, titles);
+      return written ? QString() : writer.errorString();
+    });
+  });
+}
+
+void MainWindow::on_actionOverlayCapture_triggered()
+{
+  const QString text = "Captura de texto con tiempo y nivel (*.csv *.txt)";
+  const QString int8 = "Muestras de 8 bits (*.bin *.raw)";
+  const QString int16 = "Muestras de 16 bits (*.bin *.raw)";
+  const QString float32 = "Muestras de 32 bits flotante (*.bin *.raw *.f32)";
+  QString filter = text;
+  const QString fileName = QFileDialog::getOpenFileName(this, "Superponer captura", QString(),
+                                                        QStringList({text, int8, int16, float32}).join(";;"),
+                                                        &filter);
+  if (fileName.isEmpty())
+  {
+    return;
+  }
+  const CaptureReader::Format format = filter == int8 ? CaptureReader::Format::INT8
+                                     : filter == int16 ? CaptureReader::Format::INT16
+                                     : filter == float32 ? CaptureReader::Format::FLOAT32
+                                     : CaptureReader::Format::TEXT;
+  bool accepted = true;
+  double sampleRate = 1;
+  double voltsPerUnit = 1;
+  if (format != CaptureReader::Format::TEXT)
+  { // Raw samples do not say when they were taken nor what they measure
+    sampleRate = QInputDialog::getDouble(this, "Superponer captura", "Frecuencia de muestreo (Hz):",
+                                         DEFAULT_SAMPLE_RATE, 0.001, 1e12, 3, &accepted);
+    voltsPerUnit = accepted ? QInputDialog::getDouble(this, "Superponer captura", "Voltios por unidad:",
+                                                      1, -1e9, 1e9, 9, &accepted)
+                            : 0;
+  }
+  QStringList titles;
+  for (const Trace& trace : traces)
+  {
+    titles << trace.title->text();
+  }
+  const QString title = accepted ? QInputDialog::getItem(this, "Superponer captura", "Traza:", titles,
+                                                         qMin(1, titles.size() - 1), false, &accepted)
+                                 : QString();
+  if (!accepted)
+  {
+    return;
+  }
+
+  // Parsed from the mapped file and put into a plot data map on the thread pool, the map is
+  // swapped into the graph like the encodings
+  typedef QPair<QCPDataMap*, QString> Capture;
+  auto watcher = new QFutureWatcher<Capture>(this);
+  connect(watcher, &QFutureWatcherBase::finished, [=]()
+  {
+    const Capture capture = watcher->result();
+    watcher->deleteLater();
+    if (!capture.first)
     {
-      customPlot->graph(0)->setData(binaryEncoder.generateNRZI());
-      customPlot->yAxis->setRange(-SIGNAL_AMPLITUDE, SIGNAL_AMPLITUDE);
-      customPlot->setToolTip("Codificación NRZ-I");
-      plotTitle->setText("Codificación NRZ-I");
+      ui->statusBar->showMessage(QString("No se pudo leer %1: %2").arg(fileName, capture.second),
+                                 STATUS_BAR_MESSAGE_DURATION);
+      return;
     }
-    else if (selectedCheckBox == ui->bip_checkBox)
+    stagePlotChange(ui->waveformPlot, [=]()
+    {
+      // The traces may have changed meanwhile, the capture goes over the one of the same method
+      const auto sameMethod = std::find_if(traces.begin(), traces.end(), [&](const Trace& trace)
+      {
+        return trace.title->text() == title;
+      });
+      if (sameMethod == traces.end())
+      {
+        delete capture.first;
+        return;
+      }
+      Trace& trace = *sameMethod;
+      if (!trace.capture)
+      {
+        trace.capture = ui->waveformPlot->addGraph(trace.axisRect->axis(QCPAxis::atBottom),
+                                                   trace.axisRect->axis(QCPAxis::atLeft));
+        QPen pen(QColor(0, 160, 0, 170));
+        pen.setWidthF(1.5);
+        trace.capture->setPen(pen);
+      }
+      trace.capture->data()->swap(*capture.first);
+      QCPDataMap* replaced = capture.first;
+      QtConcurrent::run([replaced]() { delete replaced; });
+    });
+    ui->statusBar->showMessage(QString("Superpuesto %1").arg(fileName), STATUS_BAR_MESSAGE_DURATION);
+  });
+  watcher->setFuture(QtConcurrent::run([=]()
+  {
+    CaptureReader reader(fileName, format, sampleRate, voltsPerUnit);
+    if (!reader.read())
     {
-      customPlot->graph(0)->setData(binaryEncoder.generateBipolar());
-      customPlot->yAxis->setRange(-SIGNAL_AMPLITUDE, SIGNAL_AMPLITUDE);
-      customPlot->setToolTip("Codificación Bipolar");
-      plotTitle->setText("Codificación Bipolar");
+      return Capture(nullptr, reader.errorString());
     }
-    else if (selectedCheckBox == ui->pset_checkBox)
+    // Straight from the parsed chunks, the last one first as the points are prepended
+    const QVector<BinaryEncoder::Data> chunks = reader.takeChunks();
+    QCPDataMap* data = new QCPDataMap;
+    for (int i = chunks.size() - 1; i >= 0; --i)
     {
-      customPlot->graph(0)->setData(binaryEncoder.generatePseudoternary());
-      customPlot->yAxis->setRange(-SIGNAL_AMPLITUDE, SIGNAL_AMPLITUDE);
-      customPlot->setToolTip("Codificación Pseudo-ternaria");
-      plotTitle->setText("Codificación Pseudo-ternaria");
+      EncodingJob::prependPoints(data, chunks[i]);
     }
-    else if (selectedCheckBox == ui->manch_checkBox)
+    return Capture(data, QString());
+  }));
+  ui->statusBar->showMessage("Leyendo captura...");
+}
+
+void MainWindow::on_actionOpenWaveforms_triggered()
+{
+  const QString fileName = QFileDialog::getOpenFileName(this, "Abrir codificación", QString(),
+                                                        "Formas de onda (*.bew)");
+  if (fileName.isEmpty())
+  {
+    return;
+  }
+  // Only the header and the chunk index are read here, the plots page the rest from the file
+  QSharedPointer<WaveformFileReader> file(new WaveformFileReader(fileName));
+  if (!file->open())
+  {
+    ui->statusBar->showMessage(QString("No se pudo abrir %1: %2").arg(fileName, file->errorString()),
+                               STATUS_BAR_MESSAGE_DURATION);
+    return;
+  }
+  if (encodingJob->isRunning())
+  {
+    stopEncoding(QString());
+  }
+  waveformFile = file;
+  stagePlotChange(ui->waveformPlot, [=]()
+  {
+    if (file == waveformFile)
+    { // A new range pages the file through rangeChanged, the same one has to be paged here
+      const QCPRange shown = traces.first().axisRect->axis(QCPAxis::atBottom)->range();
+      layoutTraces(file->tracks(), file->amplitude(), 1.0 / file->transSpeed(), file->bitCount());
+      if (traces.first().axisRect->axis(QCPAxis::atBottom)->range() == shown)
+      {
+        pageWaveforms();
+      }
+    }
+  });
+  ui->statusBar->showMessage(QString("Abierto %1").arg(fileName), STATUS_BAR_MESSAGE_DURATION);
+}
+
+void MainWindow::pageWaveforms()
+{
+  if (!waveformFile)
+  {
+    return;
+  }
+  if (paging)
+  { // The window is read again when the page in flight arrives
+    pageAgain = true;
+    return;
+  }
+  paging = true;
+  const QSharedPointer<WaveformFileReader> file = waveformFile;
+  const QCPRange window = traces.first().axisRect->axis(QCPAxis::atBottom)->range();
+  auto watcher = new QFutureWatcher<QVector<QCPDataMap*>>(this);
+  connect(watcher, &QFutureWatcherBase::finished, [=]()
+  {
+    const QVector<QCPDataMap*> data = watcher->result();
+    watcher->deleteLater();
+    paging = false;
+    stagePlotChange(ui->waveformPlot, [=]()
     {
-      customPlot->graph(0)->setData(binaryEncoder.generateManchester());
-      customPlot->yAxis->setRange(-SIGNAL_AMPLITUDE, SIGNAL_AMPLITUDE);
-      customPlot->setToolTip("Codificación Manchester");
-      plotTitle->setText("Codificación Manchester");
+      if (file != waveformFile || data.size() != traces.size())
+      {
+        qDeleteAll(data);
+        return;
+      }
+      for (int i = 0; i < data.size(); ++i)
+      {
+        replaceTraceData(i, data[i]);
+      }
+    });
+    if (pageAgain)
+    {
+      pageAgain = false;
+      pageWaveforms();
     }
-    else if (selectedCheckBox == ui->manchd_checkBox)
+  });
+  watcher->setFuture(QtConcurrent::run([=]()
+  {
+    QVector<QCPDataMap*> data;
+    for (int i = 0; i < file->tracks().size(); ++i)
     {
-      customPlot->graph(0)->setData(binaryEncoder.generateDManchester());
-      customPlot->yAxis->setRange(-SIGNAL_AMPLITUDE, SIGNAL_AMPLITUDE);
-      customPlot->setToolTip("Codificación Manchester diferencial");
-      plotTitle->setText("Codificación Manchester diferencial");
+      data << new QCPDataMap;
+      EncodingJob::prependPoints(data.last(), file->points(i, window.lower, window.upper));
     }
-    else if (selectedCheckBox == ui->mlevel_checkBox)
+    return data;
+  }));
+}
+
+void MainWindow::stagePlotChange(QCustomPlot* customPlot, std::function<void()> change)
+{
+  // Plots are never touched here, every dirty plot is updated and rendered once on the next event
+  // loop pass, and not before the renders already in flight are done with them
+  stagedChanges << change;
+  dirtyPlots << customPlot;
+  if (!replotScheduled)
+  {
+    replotScheduled = true;
+    QMetaObject::invokeMethod(this, "flushReplots", Qt::QueuedConnection);
+  }
+}
+
+static MainWindow::RenderedPlot renderPlot(QCustomPlot* customPlot)
+{
+  QElapsedTimer timer;
+  timer.start();
+  MainWindow::RenderedPlot rendered;
+  rendered.customPlot = customPlot;
+  rendered.buffer = customPlot->renderReplot();
+  rendered.renderTime = timer.nsecsElapsed();
+  return rendered;
+}
+
+void MainWindow::flushReplots()
+{
+  replotScheduled = false;
+  if (renderWatcher.isRunning())
+  { // renderFinished() flushes again
+    return;
+  }
+  // Changes may stage more changes, those wait for the next flush
+  const QList<std::function<void()>> changes = stagedChanges;
+  stagedChanges.clear();
+  for (const std::function<void()>& change : changes)
+  {
+    change();
+  }
+  QElapsedTimer layoutTimer;
+  layoutTimer.start();
+  QList<QCustomPlot*> renderingPlots;
+  for (QCustomPlot* customPlot : dirtyPlots)
+  {
+    if (customPlot->prepareReplot())
     {
-      const int levels = ui->l2radioButton->isChecked() ? 2 :
-                  ui->l4radioButton->isChecked() ? 4 : 8;
-      customPlot->graph(0)->setData(binaryEncoder.generateMultilevel(levels));
-      customPlot->yAxis->setRange(-SIGNAL_AMPLITUDE, SIGNAL_AMPLITUDE);
-      customPlot->setToolTip(QString("Codificación de %1 niveles").arg(levels));
-      plotTitle->setText(QString("Codificación de %1 niveles").arg(levels));
+      renderingPlots << customPlot;
     }
-    customPlot->xAxis->setRange(0, binaryEncoder.timeMax());
-    customPlot->xAxis->setAutoTickCount(MSG_LENGHT - 1);
-    customPlot->replot();
-    customPlotIt++;
   }
+  dirtyPlots.clear();
+  if (encodingRendering)
+  {
+    stageTimes.layout += layoutTimer.nsecsElapsed();
+  }
+  // Rendered off the GUI thread, which only blits the results. Every trace lives in waveformPlot
+  // now, so this is a single render, mapped() only keeps plots apart if more are ever added
+  renderWatcher.setFuture(QtConcurrent::mapped(renderingPlots, renderPlot));
 }
 
-void MainWindow::clearPlots()
+void MainWindow::renderFinished()
 {
-  for (QCustomPlot* customPlot : customPlots) {
-    customPlot->graph(0)->clearData();
-    customPlot->replot();
-    QCPPlotTitle* plotTitle = (QCPPlotTitle*) customPlot->plotLayout()->element(0, 0);
-    plotTitle->setText("");
+  QStringList renderTimes;
+  qint64 slowestTime = 0;
+  QElapsedTimer blitTimer;
+  blitTimer.start();
+  for (const RenderedPlot& rendered : renderWatcher.future().results())
+  {
+    rendered.customPlot->finishReplot(rendered.buffer);
+    slowestTime = qMax(slowestTime, rendered.renderTime);
+    renderTimes << QString("%1 %2 ms").arg(rendered.customPlot->objectName())
+                   .arg(rendered.renderTime / 1e6, 0, 'f', 1);
+  }
+  if (encodingRendering)
+  {
+    stageTimes.replot = slowestTime;
+    stageTimes.blit = blitTimer.nsecsElapsed();
+    const StageTimes times = stageTimes;
+    stageTimes = StageTimes();
+    encodingRendering = false;
+    emit encodingPlotted(times);
+  }
+  if (liveFrameRendering && liveLatency.isValid())
+  {
+    const qint64 latency = liveLatency.nsecsElapsed();
+    latencyLabel->setText(QString("Latencia: %1 ms").arg(latency / 1e6, 0, 'f', 1));
+    latencyLabel->setStyleSheet(latency > LIVE_LATENCY_BUDGET * 1000000 ? "color: red;" : "");
+    liveLatency.invalidate();
+  }
+  liveFrameRendering = false;
+  if (!renderTimes.isEmpty())
+  {
+    ui->statusBar->showMessage(QString("Dibujado en %1 ms (%2)").arg(slowestTime / 1e6, 0, 'f', 1)
+                               .arg(renderTimes.join(", ")), STATUS_BAR_MESSAGE_DURATION);
+  }
+  if (!stagedChanges.isEmpty() && !replotScheduled)
+  {
+    replotScheduled = true;
+    QMetaObject::invokeMethod(this, "flushReplots", Qt::QueuedConnection);
   }
 }
 
@@ -323,23 +1162,10 @@ void MainWindow::configureForAndroid()
   groupBoxLayout->invalidate();
 
   ui->messageLineEdit->setMinimumHeight(30);
-  ui->binaryMessageLineEdit->setMinimumHeight(30);
+  ui->binaryMessageView->setMinimumHeight(30);
 
   ui->groupBox->setTitle("Métodos de codificación:");
 
 }
 
 #endif // Q_OS_ANDROID
-
-// Local functions
-
-QString hex2bin(const QString& hex)
-{
-  qlonglong binary = hex.toLongLong(nullptr, 16);
-  QString strBinary = QString::number(binary, 2);
-  int necesaryBIts = hex.length() * 4;
-  while (strBinary.length() < necesaryBIts) {
-    strBinary = "0" + strBinary;
-  }
-  return strBinary;
-}
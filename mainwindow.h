@@ -1,12 +1,36 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include "bitbuffer.h"
+
 #include <QMainWindow>
 
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QImage>
 #include <QLinkedList>
+#include <QMap>
+#include <QSet>
+#include <QSharedPointer>
+#include <QTimer>
+
+#include <functional>
 
+class QCPData;
 class QCustomPlot;
+class QCPAxisRect;
+class QCPGraph;
+class QCPMarginGroup;
+class QCPPlotTitle;
 class QCheckBox;
+class QLabel;
+
+namespace chrishenx {
+  class BitTicker;
+  class EncodingJob;
+  class WaveformFileReader;
+  struct WaveformTrack;
+}
 
 namespace Ui {
 class MainWindow;
@@ -20,28 +44,115 @@ public:
   explicit MainWindow(QWidget *parent = 0);
   ~MainWindow();
 
+  bool eventFilter(QObject* watched, QEvent* event) override;
+
+  struct RenderedPlot
+  {
+    QCustomPlot* customPlot;
+    QImage buffer;
+    qint64 renderTime; // ns
+  };
+
+  // Time spent on every stage of an encoding until it is on screen, in ns
+  struct StageTimes
+  {
+    qint64 conversion = 0; // Hexadecimal digits to bits, of every edit since the previous encoding
+    qint64 encoding = 0; // From the start of the encoding until its points are ready
+    qint64 setData = 0; // Swapping the points into the graphs
+    qint64 layout = 0; // Of the traces and the plot
+    qint64 replot = 0; // Rendering of the slowest plot
+    qint64 blit = 0; // Adopting the renders
+  };
+
+signals:
+  void encodingPlotted(const MainWindow::StageTimes& times);
+
 private slots:
   void on_messageLineEdit_textEdited(const QString &input);
   void on_pushButton_clicked();
-
+  void on_actionSaveWaveforms_triggered();
+  void on_actionOpenWaveforms_triggered();
+  void on_actionExportAudio_triggered();
+  void on_actionExportTable_triggered();
+  void on_actionExportImage_triggered();
+  void on_actionExportFigure_triggered();
+  void on_actionOverlayCapture_triggered();
+  void flushReplots();
+  void renderFinished();
 
 private:
   Ui::MainWindow *ui;
 
-  static const int ALLOWED_METHODS_CHECKED = 3; // Equal to the number of QCustomPlots
   static const int STATUS_BAR_MESSAGE_DURATION = 4000; // ms
+  static const int TRACE_HEIGHT = 120; // px
+  static const int LIVE_DEBOUNCE_INTERVAL = 4; // ms
+  static const int LIVE_LATENCY_BUDGET = 16; // ms, a frame at 60 Hz
+  static const int DEFAULT_SAMPLE_RATE = 48000; // Hz
+  static const int DEFAULT_BIT_WIDTH = 16; // px, of the exported images
+  static const double WHEEL_ZOOM_FACTOR; // Of the time range, per wheel step
+
+  // One stacked axis rect of waveformPlot
+  struct Trace
+  {
+    QCPPlotTitle* title;
+    QCPAxisRect* axisRect;
+    QCPGraph* graph;
+    chrishenx::BitTicker* ticker;
+    QCPGraph* capture = nullptr; // Captured waveform drawn over the encoding
+  };
 
   QLinkedList<QCheckBox*> methodCheckBoxes;
   QLinkedList<QCheckBox*> selectedCheckBoxes;
-  QList<QCustomPlot*> customPlots;
+  QList<Trace> traces; // The first one is the clock
+  QCPMarginGroup* marginGroup;
+  QList<std::function<void()>> stagedChanges; // Plot changes waiting for the next flushReplots()
+  QSet<QCustomPlot*> dirtyPlots;
+  bool replotScheduled = false;
+  QFutureWatcher<RenderedPlot> renderWatcher;
+  chrishenx::EncodingJob* encodingJob;
+  QTimer liveTimer; // Debounces the edits in live mode
+  QElapsedTimer liveLatency;
+  bool liveFrameRendering = false; // The render in flight shows a live encoding
+  bool encodingRendering = false; // The render in flight shows an encoding
+  StageTimes stageTimes; // Of the encoding on its way to the screen
+  QLabel* latencyLabel;
+  QSharedPointer<chrishenx::WaveformFileReader> waveformFile; // Shown instead of messageBits when set
+  bool paging = false; // Reading the window of waveformFile
+  bool pageAgain = false; // The window moved while paging
+  bool panning = false; // Dragging the traces
+  int panX = 0; // px, where the last staged drag ended
 
   QString message;
+  chrishenx::BitBuffer messageBits; // Packed binary representation of message
+
+  // State of messageLineEdit right before an edit
+  int editCursor = 0;
+  int editSelectionStart = -1;
+  int editSelectionLength = 0;
+  bool editTracked = true; // False after edits that do not start at the cursor, like undo
 
   void configureMethodCheckBoxes();
   void configureLineEditFonts();
-  void configureCustomPlots();
+  void configureEditTracking();
+  bool locateEdit(const QString& input, qint64& start, qint64& removed, qint64& inserted) const;
+  void configureWaveformPlot();
+  void configureTrace(Trace& trace);
+  void setTraceCount(int count);
+  void configureLiveMode();
+  void scheduleLivePlot();
+  QVector<chrishenx::WaveformTrack> selectedTraces() const;
+  void layoutTraces(const QVector<chrishenx::WaveformTrack>& kinds, double amplitude, double bitPeriod,
+                    qint64 bitCount);
+  void replaceTraceData(int index, QMap<double, QCPData>* data);
   void plotSelectedMethods();
-  void clearPlots();
+  void pageWaveforms();
+  bool navigateWaveforms(QEvent* event); // True when the event dragged or zoomed the traces
+  void stopEncoding(const QString& statusMessage);
+  void stagePlotChange(QCustomPlot* customPlot, std::function<void()> change);
+  bool checkMessage(); // False when there is none to export, saying so on the status bar
+  // Runs task, which returns what went wrong or nothing, on the thread pool and says on the status
+  // bar whether target got written
+  void runExport(const QString& target, std::function<QString()> task, bool saving = false);
 #ifdef Q_OS_ANDROID
   void configureForAndroid();
 #endif
@@ -0,0 +1,109 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2015 Christian González León
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+  */
+
+#include "mappedfile.h"
+
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#endif
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#endif
+
+using namespace chrishenx;
+
+bool MappedFile::map(Access access)
+{
+  unmap();
+  if (!mFile.open(QIODevice::ReadOnly) || !mapFile())
+  {
+    return false;
+  }
+#ifdef Q_OS_UNIX
+  // Sequential reads ahead aggressively and drops the pages behind, random reads only what is touched
+  if (mData)
+  {
+    madvise(mData, size_t(mSize), access == Access::SEQUENTIAL ? MADV_SEQUENTIAL : MADV_RANDOM);
+  }
+#else
+  Q_UNUSED(access);
+#endif
+  return true;
+}
+
+bool MappedFile::create(qint64 size)
+{
+  unmap();
+  if (!mFile.open(QIODevice::ReadWrite | QIODevice::Truncate))
+  {
+    return false;
+  }
+#ifdef Q_OS_LINUX
+  // Unlike a sparse resize the blocks are reserved now, a full disk fails here instead of
+  // killing the writer with SIGBUS in the middle of the mapping
+  if (size > 0 && fallocate(mFile.handle(), 0, 0, off_t(size)) != 0 && errno != EOPNOTSUPP)
+  {
+    mError = QString::fromLocal8Bit(strerror(errno));
+    mFile.close();
+    return false;
+  }
+#endif
+  if (!mFile.resize(size) || !mapFile())
+  {
+    mFile.close();
+    return false;
+  }
+  return true;
+}
+
+bool MappedFile::mapFile()
+{
+  mSize = mFile.size();
+  if (mSize == 0)
+  { // Nothing to map, an empty mapping is an error
+    return true;
+  }
+  mData = mFile.map(0, mSize);
+  if (!mData)
+  {
+    mSize = 0;
+    mFile.close();
+    return false;
+  }
+  return true;
+}
+
+void MappedFile::unmap()
+{
+  if (mData)
+  {
+    mFile.unmap(mData);
+    mData = nullptr;
+  }
+  mSize = 0;
+  mError.clear();
+  mFile.close();
+}
@@ -0,0 +1,67 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2015 Christian González León
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+  */
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <QFile>
+#include <QString>
+
+namespace chrishenx {
+
+  // A whole file mapped into memory, so files larger than any QByteArray can be read or written
+  // without copying them through buffers
+  class MappedFile
+  {
+  public:
+    enum class Access { SEQUENTIAL, RANDOM }; // Read ahead hint
+
+    explicit MappedFile(const QString& fileName) : mFile(fileName) {}
+    ~MappedFile() { unmap(); }
+
+    // Both return false on failure and errorString() says why
+    bool map(Access access = Access::SEQUENTIAL); // Read only
+    bool create(qint64 size); // Replaced by size bytes allocated on disk, mapped for writing
+    void unmap();
+
+    const uchar* data() const { return mData; }
+    uchar* data() { return mData; }
+    qint64 size() const { return mSize; }
+    QString errorString() const { return mError.isEmpty() ? mFile.errorString() : mError; }
+
+  private:
+    Q_DISABLE_COPY(MappedFile)
+
+    QFile mFile;
+    uchar* mData = nullptr;
+    qint64 mSize = 0;
+    QString mError; // When the failure was not the file's
+
+    bool mapFile();
+  };
+
+} // chrishenx namespace end
+
+
+#endif // MAPPEDFILE_H
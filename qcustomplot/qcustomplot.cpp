@@ -24,6 +24,7 @@
 ****************************************************************************/
 
 #include "qcustomplot.h"
+#include "tracing.h" // chrishenx modification
 
 
 
@@ -3822,12 +3823,19 @@ void QCPGrid::drawGridLines(QCPPainter *painter) const
     // draw grid lines:
     applyDefaultAntialiasingHint(painter);
     painter->setPen(mPen);
+    // chrishenx modification: grid lines are batched into a single drawLines call
+    const bool snap = !painter->antialiasing() && !painter->modes().testFlag(QCPPainter::pmVectorized); // as QCPPainter::drawLine
+    QVector<QLineF> lines;
+    lines.reserve(highTick-lowTick+1);
     for (int i=lowTick; i <= highTick; ++i)
     {
       if (i == zeroLineIndex) continue; // don't draw a gridline on top of the zeroline
       t = mParentAxis->coordToPixel(mParentAxis->mTickVector.at(i)); // x
-      painter->drawLine(QLineF(t, mParentAxis->mAxisRect->bottom(), t, mParentAxis->mAxisRect->top()));
+      if (snap) t = qRound(t);
+      lines.append(QLineF(t, mParentAxis->mAxisRect->bottom(), t, mParentAxis->mAxisRect->top()));
     }
+    painter->drawLines(lines);
+    // chrishenx modification end
   } else
   {
     // draw zeroline:
@@ -3851,12 +3859,19 @@ void QCPGrid::drawGridLines(QCPPainter *painter) const
     // draw grid lines:
     applyDefaultAntialiasingHint(painter);
     painter->setPen(mPen);
+    // chrishenx modification: grid lines are batched into a single drawLines call
+    const bool snap = !painter->antialiasing() && !painter->modes().testFlag(QCPPainter::pmVectorized); // as QCPPainter::drawLine
+    QVector<QLineF> lines;
+    lines.reserve(highTick-lowTick+1);
     for (int i=lowTick; i <= highTick; ++i)
     {
       if (i == zeroLineIndex) continue; // don't draw a gridline on top of the zeroline
       t = mParentAxis->coordToPixel(mParentAxis->mTickVector.at(i)); // y
-      painter->drawLine(QLineF(mParentAxis->mAxisRect->left(), t, mParentAxis->mAxisRect->right(), t));
+      if (snap) t = qRound(t);
+      lines.append(QLineF(mParentAxis->mAxisRect->left(), t, mParentAxis->mAxisRect->right(), t));
     }
+    painter->drawLines(lines);
+    // chrishenx modification end
   }
 }
 
@@ -3873,21 +3888,29 @@ void QCPGrid::drawSubGridLines(QCPPainter *painter) const
   applyAntialiasingHint(painter, mAntialiasedSubGrid, QCP::aeSubGrid);
   double t; // helper variable, result of coordinate-to-pixel transforms
   painter->setPen(mSubGridPen);
+  // chrishenx modification: sub grid lines are batched into a single drawLines call
+  const bool snap = !painter->antialiasing() && !painter->modes().testFlag(QCPPainter::pmVectorized); // as QCPPainter::drawLine
+  QVector<QLineF> lines;
+  lines.reserve(mParentAxis->mSubTickVector.size());
   if (mParentAxis->orientation() == Qt::Horizontal)
   {
     for (int i=0; i<mParentAxis->mSubTickVector.size(); ++i)
     {
       t = mParentAxis->coordToPixel(mParentAxis->mSubTickVector.at(i)); // x
-      painter->drawLine(QLineF(t, mParentAxis->mAxisRect->bottom(), t, mParentAxis->mAxisRect->top()));
+      if (snap) t = qRound(t);
+      lines.append(QLineF(t, mParentAxis->mAxisRect->bottom(), t, mParentAxis->mAxisRect->top()));
     }
   } else
   {
     for (int i=0; i<mParentAxis->mSubTickVector.size(); ++i)
     {
       t = mParentAxis->coordToPixel(mParentAxis->mSubTickVector.at(i)); // y
-      painter->drawLine(QLineF(mParentAxis->mAxisRect->left(), t, mParentAxis->mAxisRect->right(), t));
+      if (snap) t = qRound(t);
+      lines.append(QLineF(mParentAxis->mAxisRect->left(), t, mParentAxis->mAxisRect->right(), t));
     }
   }
+  painter->drawLines(lines);
+  // chrishenx modification end
 }
 
 
@@ -6396,7 +6419,7 @@ void QCPAxisPainterPrivate::placeTickLabel(QCPPainter *painter, double position,
       CachedLabel *newCachedLabel = new CachedLabel;
       TickLabelData labelData = getTickLabelData(painter->font(), text);
       newCachedLabel->offset = getTickLabelDrawOffset(labelData)+labelData.rotatedTotalBounds.topLeft();
-      newCachedLabel->pixmap = QPixmap(labelData.rotatedTotalBounds.size());
+      newCachedLabel->pixmap = QImage(labelData.rotatedTotalBounds.size(), QImage::Format_ARGB32_Premultiplied); // chrishenx modification
       newCachedLabel->pixmap.fill(Qt::transparent);
       QCPPainter cachePainter(&newCachedLabel->pixmap);
       cachePainter.setPen(painter->pen());
@@ -6420,7 +6443,7 @@ void QCPAxisPainterPrivate::placeTickLabel(QCPPainter *painter, double position,
           return;
       }
     }
-    painter->drawPixmap(labelAnchor+cachedLabel->offset, cachedLabel->pixmap);
+    painter->drawImage(labelAnchor+cachedLabel->offset, cachedLabel->pixmap); // chrishenx modification
     finalSize = cachedLabel->pixmap.size();
   } else // label caching disabled, draw text directly on surface:
   {
@@ -9053,7 +9076,9 @@ QCustomPlot::QCustomPlot(QWidget *parent) :
   mMultiSelectModifier(Qt::ControlModifier),
   mPaintBuffer(size()),
   mMouseEventElement(0),
-  mReplotting(false)
+  mReplotting(false),
+  mAsyncReplotting(false), // chrishenx modification
+  mReplotDeferred(false) // chrishenx modification
 {
   setAttribute(Qt::WA_NoMousePropagation);
   setAttribute(Qt::WA_OpaquePaintEvent);
@@ -10378,8 +10403,15 @@ void QCustomPlot::deselectAll()
 */
 void QCustomPlot::replot(QCustomPlot::RefreshPriority refreshPriority)
 {
+  chrishenx::TraceScope traceScope("QCustomPlot::replot"); // chrishenx modification
   if (mReplotting) // incase signals loop back to replot slot
+  {
+    // chrishenx modification
+    if (mAsyncReplotting)
+      mReplotDeferred = true;
+    // chrishenx modification end
     return;
+  }
   mReplotting = true;
   emit beforeReplot();
   
@@ -10404,6 +10436,85 @@ void QCustomPlot::replot(QCustomPlot::RefreshPriority refreshPriority)
   mReplotting = false;
 }
 
+// chrishenx modification
+
+/*!
+  First step of a replot whose rasterization happens on another thread. Runs the layout on the
+  calling (GUI) thread and locks the plot against further replots until \ref finishReplot. Returns
+  false if a replot is already running or the plot has zero size, in which case neither \ref
+  renderReplot nor \ref finishReplot may be called.
+  
+  Between this call and \ref finishReplot the plot, its layout and its plottables must not be
+  modified.
+*/
+bool QCustomPlot::prepareReplot()
+{
+  chrishenx::TraceScope traceScope("QCustomPlot::prepareReplot");
+  if (mReplotting || mPaintBuffer.isNull())
+    return false;
+  mReplotting = true;
+  mAsyncReplotting = true;
+  emit beforeReplot();
+  
+  mPlotLayout->update(QCPLayoutElement::upPreparation);
+  mPlotLayout->update(QCPLayoutElement::upMargins);
+  mPlotLayout->update(QCPLayoutElement::upLayout);
+  mAsyncBufferSize = mPaintBuffer.size();
+  return true;
+}
+
+/*!
+  Second step of an off-thread replot, safe to call from a worker thread. Draws all layers into a
+  QImage the size of the paint buffer at the time of \ref prepareReplot. The tick label cache holds
+  QImages, so it is used here like in \ref replot; nothing else touches it while the plot is locked.
+*/
+QImage QCustomPlot::renderReplot()
+{
+  chrishenx::TraceScope traceScope("QCustomPlot::renderReplot");
+  QImage buffer(mAsyncBufferSize, QImage::Format_ARGB32_Premultiplied);
+  buffer.fill(mBackgroundBrush.style() == Qt::SolidPattern ? mBackgroundBrush.color() : Qt::transparent);
+  QCPPainter painter;
+  if (painter.begin(&buffer))
+  {
+    painter.setRenderHint(QPainter::HighQualityAntialiasing);
+    if (mBackgroundBrush.style() != Qt::SolidPattern && mBackgroundBrush.style() != Qt::NoBrush)
+      painter.fillRect(mViewport, mBackgroundBrush);
+    drawLayers(&painter);
+    painter.end();
+  }
+  return buffer;
+}
+
+/*!
+  Last step of an off-thread replot, on the GUI thread. Adopts \a buffer as the new paint buffer,
+  refreshes the widget according to \a refreshPriority and unlocks the plot. Replots requested
+  while the render was running, e.g. by a resize, are performed now.
+*/
+void QCustomPlot::finishReplot(const QImage &buffer, QCustomPlot::RefreshPriority refreshPriority)
+{
+  chrishenx::TraceScope traceScope("QCustomPlot::finishReplot");
+  if (!mAsyncReplotting)
+    return;
+  if (buffer.size() == mPaintBuffer.size())
+    mPaintBuffer = QPixmap::fromImage(buffer);
+  if (refreshPriority == rpImmediate)
+    repaint();
+  else
+    update();
+  
+  emit afterReplot();
+  mAsyncReplotting = false;
+  mReplotting = false;
+  if (mReplotDeferred)
+  {
+    mReplotDeferred = false;
+    setViewport(rect());
+    replot(rpQueued);
+  }
+}
+
+// chrishenx modification end
+
 /*!
   Rescales the axes such that all plottables (like graphs) in the plot are fully visible.
   
@@ -10682,6 +10793,14 @@ void QCustomPlot::resizeEvent(QResizeEvent *event)
 {
   // resize and repaint the buffer:
   mPaintBuffer = QPixmap(event->size());
+  // chrishenx modification
+  if (mAsyncReplotting) // the layout is in use by renderReplot, finishReplot applies the new viewport
+  {
+    mPaintBuffer.fill(mBackgroundBrush.style() == Qt::SolidPattern ? mBackgroundBrush.color() : Qt::transparent);
+    mReplotDeferred = true;
+    return;
+  }
+  // chrishenx modification end
   setViewport(rect());
   replot(rpQueued); // queued update is important here, to prevent painting issues in some contexts
 }
@@ -10887,6 +11006,18 @@ void QCustomPlot::draw(QCPPainter *painter)
   mPlotLayout->update(QCPLayoutElement::upMargins);
   mPlotLayout->update(QCPLayoutElement::upLayout);
   
+  // chrishenx modification
+  drawLayers(painter);
+}
+
+/*! \internal
+  
+  Draws the viewport background pixmap and all layers, assuming the layout is up to date. Split
+  from \ref draw so \ref renderReplot can run it off the GUI thread.
+*/
+void QCustomPlot::drawLayers(QCPPainter *painter)
+{
+  // chrishenx modification end
   // draw viewport background pixmap:
   drawBackground(painter);
 
@@ -14534,6 +14665,7 @@ QCPGraph::~QCPGraph()
 */
 void QCPGraph::setData(QCPDataMap *data, bool copy)
 {
+  chrishenx::TraceScope traceScope("QCPGraph::setData"); // chrishenx modification
   if (mData == data)
   {
     qDebug() << Q_FUNC_INFO << "The data pointer is already in (and owned by) this plottable" << reinterpret_cast<quintptr>(data);
@@ -14557,6 +14689,7 @@ void QCPGraph::setData(QCPDataMap *data, bool copy)
 */
 void QCPGraph::setData(const QVector<double> &key, const QVector<double> &value)
 {
+  chrishenx::TraceScope traceScope("QCPGraph::setData"); // chrishenx modification
   mData->clear();
   int n = key.size();
   n = qMin(n, value.size());
@@ -14572,6 +14705,7 @@ void QCPGraph::setData(const QVector<double> &key, const QVector<double> &value)
 // chrishenx modification
 void QCPGraph::setData(const QVector<std::pair<double, double>>& data)
 {
+    chrishenx::TraceScope traceScope("QCPGraph::setData");
     mData->clear();
     int n = data.size();
     QCPData newData;
@@ -15592,6 +15726,7 @@ void QCPGraph::drawScatterPlot(QCPPainter *painter, QVector<QCPData> *scatterDat
 */
 void QCPGraph::drawLinePlot(QCPPainter *painter, QVector<QPointF> *lineData) const
 {
+  chrishenx::TraceScope traceScope("QCPGraph::drawLinePlot"); // chrishenx modification
   // draw line of graph:
   if (mainPen().style() != Qt::NoPen && mainPen().color().alpha() != 0)
   {
@@ -15685,6 +15820,7 @@ void QCPGraph::drawImpulsePlot(QCPPainter *painter, QVector<QPointF> *lineData)
 */
 void QCPGraph::getPreparedData(QVector<QCPData> *lineData, QVector<QCPData> *scatterData) const
 {
+  chrishenx::TraceScope traceScope("QCPGraph::getPreparedData"); // chrishenx modification
   QCPAxis *keyAxis = mKeyAxis.data();
   QCPAxis *valueAxis = mValueAxis.data();
   if (!keyAxis || !valueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return; }
@@ -33,6 +33,7 @@
 #include <QPaintEvent>
 #include <QMouseEvent>
 #include <QPixmap>
+#include <QImage> // chrishenx modification
 #include <QVector>
 #include <QString>
 #include <QDateTime>
@@ -1366,7 +1367,7 @@ protected:
   struct CachedLabel
   {
     QPointF offset;
-    QPixmap pixmap;
+    QImage pixmap; // chrishenx modification, a QImage so renderReplot can draw it off the GUI thread
   };
   struct TickLabelData
   {
@@ -1819,6 +1820,11 @@ public:
   QPixmap toPixmap(int width=0, int height=0, double scale=1.0);
   void toPainter(QCPPainter *painter, int width=0, int height=0);
   Q_SLOT void replot(QCustomPlot::RefreshPriority refreshPriority=QCustomPlot::rpHint);
+  // chrishenx modification
+  bool prepareReplot();
+  QImage renderReplot();
+  void finishReplot(const QImage &buffer, QCustomPlot::RefreshPriority refreshPriority=QCustomPlot::rpQueued);
+  // chrishenx modification end
   
   QCPAxis *xAxis, *yAxis, *xAxis2, *yAxis2;
   QCPLegend *legend;
@@ -1872,6 +1878,10 @@ protected:
   QPoint mMousePressPos;
   QPointer<QCPLayoutElement> mMouseEventElement;
   bool mReplotting;
+  // chrishenx modification
+  bool mAsyncReplotting, mReplotDeferred;
+  QSize mAsyncBufferSize;
+  // chrishenx modification end
   
   // reimplemented virtual methods:
   virtual QSize minimumSizeHint() const;
@@ -1893,6 +1903,9 @@ protected:
   void updateLayerIndices() const;
   QCPLayerable *layerableAt(const QPointF &pos, bool onlySelectable, QVariant *selectionDetails=0) const;
   void drawBackground(QCPPainter *painter);
+  // chrishenx modification
+  void drawLayers(QCPPainter *painter);
+  // chrishenx modification end
   
   friend class QCPLegend;
   friend class QCPAxis;
@@ -0,0 +1,12 @@
+QT       += core concurrent testlib
+QT       -= gui
+
+TARGET = binary-encoding-tests
+TEMPLATE = app
+
+CONFIG += console c++17 testcase
+CONFIG -= app_bundle
+
+include(../encoder.pri)
+
+SOURCES += tst_encoding.cpp
@@ -0,0 +1,182 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2015 Christian González León
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+  */
+
+// Checks that what is written in pieces reads and encodes the same as the whole
+
+#include "binaryencoder.h"
+#include "waveformfile.h"
+
+#include <QBuffer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include <algorithm>
+#include <random>
+
+using namespace chrishenx;
+
+namespace {
+
+  const BinaryEncoder::Method METHODS[] = {
+    BinaryEncoder::Method::TTL, BinaryEncoder::Method::NRZL, BinaryEncoder::Method::NRZI,
+    BinaryEncoder::Method::BIPOLAR, BinaryEncoder::Method::PSEUDOTERNARY, BinaryEncoder::Method::MANCHESTER,
+    BinaryEncoder::Method::DMANCHESTER, BinaryEncoder::Method::MULTILEVEL, BinaryEncoder::Method::CLOCK
+  };
+
+  BitBuffer randomBits(qint64 size, quint64 seed)
+  {
+    std::mt19937_64 random(seed);
+    BitBuffer bits(size);
+    for (qint64 i = 0; i < size; ++i)
+    {
+      bits.setBit(i, int(random() & 1));
+    }
+    return bits;
+  }
+
+  // Level of the last point at or before time, vertical edges take their second point
+  double valueAt(const BinaryEncoder::Data& points, double time)
+  {
+    auto after = std::upper_bound(points.constBegin(), points.constEnd(), time,
+                                  [](double t, const BinaryEncoder::Point& point) { return t < point.first; });
+    return after == points.constBegin() ? qQNaN() : (after - 1)->second;
+  }
+
+} // anonymous namespace end
+
+class EncodingTest : public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void waveformFileRoundTrip();
+  void rejectEmptyChunks();
+  void encodeRangePieces();
+};
+
+void EncodingTest::waveformFileRoundTrip()
+{
+  // Enough bits for every track to span several chunks, the clock has two edges per bit
+  const qint64 bitCount = WaveformFileWriter::EDGES_PER_CHUNK * 3 + 12345;
+  const double transSpeed = 9600;
+  const double amplitude = 5;
+  const BitBuffer bits = randomBits(bitCount, 20151017);
+  QVector<WaveformTrack> tracks;
+  for (BinaryEncoder::Method method : METHODS)
+  {
+    tracks << WaveformTrack {method, method == BinaryEncoder::Method::MULTILEVEL ? 8 : BinaryEncoder::DEFAULT_LEVELS};
+  }
+
+  QTemporaryDir directory;
+  QVERIFY(directory.isValid());
+  const QString fileName = directory.filePath("roundtrip.bew");
+  {
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    QVERIFY(writeWaveformFile(&file, bits, transSpeed, amplitude, tracks));
+  }
+  WaveformFileReader reader(fileName);
+  QVERIFY2(reader.open(), qPrintable(reader.errorString()));
+  QCOMPARE(reader.bitCount(), bitCount);
+  QCOMPARE(reader.tracks().size(), tracks.size());
+
+  // Windows of a few chunks at most, so they are decoded, sliding over every chunk border
+  BinaryEncoder encoder(bits, transSpeed, amplitude);
+  const qint64 windowBits = 20000;
+  for (int track = 0; track < tracks.size(); ++track)
+  {
+    const BinaryEncoder::Data expected = encoder.encodeRange(tracks[track].method, 0, bitCount,
+                                                             tracks[track].levels);
+    for (qint64 first = 0; first < bitCount; first += windowBits / 2)
+    {
+      const qint64 last = qMin(first + windowBits, bitCount);
+      const BinaryEncoder::Data points = reader.points(track, first / transSpeed, last / transSpeed);
+      QVERIFY(!points.isEmpty());
+      // A quarter of a bit in, where no method has an edge
+      for (qint64 bit = first; bit < last; bit += 7)
+      {
+        const double time = (bit + 0.25) / transSpeed;
+        if (valueAt(expected, time) != valueAt(points, time))
+        {
+          QFAIL(qPrintable(QString("track %1 differs at bit %2").arg(track).arg(bit)));
+        }
+      }
+    }
+  }
+}
+
+void EncodingTest::rejectEmptyChunks()
+{
+  QBuffer buffer;
+  QVERIFY(buffer.open(QIODevice::WriteOnly));
+  QVERIFY(writeWaveformFile(&buffer, randomBits(100, 7), 1000, 1, {WaveformTrack {BinaryEncoder::Method::NRZL, 2}}));
+  // The edge count of the first index entry, right after the chunk count and the track
+  QByteArray bytes = buffer.data();
+  const qint64 indexOffset = qFromLittleEndian<qint64>(reinterpret_cast<const uchar*>(bytes.constData()) +
+                                                       bytes.size() - 16);
+  bytes.replace(int(indexOffset + 12), 4, QByteArray(4, '\0'));
+
+  QTemporaryDir directory;
+  QVERIFY(directory.isValid());
+  const QString fileName = directory.filePath("empty-chunk.bew");
+  {
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    QCOMPARE(file.write(bytes), qint64(bytes.size()));
+  }
+  WaveformFileReader reader(fileName);
+  QVERIFY(!reader.open());
+}
+
+void EncodingTest::encodeRangePieces()
+{
+  const qint64 bitCount = 10007;
+  const int levels = 4;
+  const BitBuffer bits = randomBits(bitCount, 42);
+  for (BinaryEncoder::Method method : METHODS)
+  {
+    BinaryEncoder encoder(bits);
+    const BinaryEncoder::Data whole = encoder.encodeRange(method, 0, bitCount, levels);
+    encoder.buildCheckpoints(levels);
+    // Pieces of several sizes, none of them aligned with the checkpoints
+    for (qint64 pieceBits : {qint64(1), qint64(97), qint64(1000), qint64(4099)})
+    {
+      BinaryEncoder::Data pieces(int(bitCount * BinaryEncoder::pointsPerBit(method) + 1));
+      qint64 written = 0;
+      for (qint64 first = 0; first < bitCount; first += pieceBits)
+      {
+        const qint64 count = qMin(pieceBits, bitCount - first);
+        written += encoder.encodeRangeInto(method, first, count, levels, pieces.data() + written);
+      }
+      pieces.resize(int(written));
+      QVERIFY2(pieces == whole, qPrintable(QString("method %1 in pieces of %2 bits")
+                                           .arg(int(method)).arg(pieceBits)));
+    }
+  }
+}
+
+QTEST_APPLESS_MAIN(EncodingTest)
+
+#include "tst_encoding.moc"
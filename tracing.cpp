@@ -0,0 +1,168 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2015 Christian González León
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+  */
+
+#include "tracing.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QSaveFile>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QThread>
+#include <QVector>
+
+using namespace chrishenx;
+
+QAtomicInt Tracer::sRecording(0);
+
+namespace {
+
+  struct Event
+  {
+    const char* name;
+    qint64 begin; // ns
+    qint64 end; // ns
+  };
+
+  // The spans of a thread, appended without touching any other thread's. Thread ids are handed out
+  // per recording, in the order the threads record their first span
+  struct ThreadBuffer
+  {
+    QMutex mutex; // Only ever waited for while stop() takes the events
+    QVector<Event> events;
+    int recording = -1;
+    int id = -1;
+    QString name;
+  };
+
+  QMutex traceMutex; // Guards everything below but the clock and the thread buffers
+  QElapsedTimer traceClock; // Only restarted while nothing is recorded
+  QVector<QSharedPointer<ThreadBuffer>> threadBuffers; // Of the current recording, by thread id
+  QString traceFileName;
+  QString traceError;
+  QAtomicInt currentRecording(0); // Each start() begins a new recording
+  thread_local QSharedPointer<ThreadBuffer> threadBuffer; // Outlives the thread while recording
+
+  QString threadName(int id)
+  {
+    QThread* thread = QThread::currentThread();
+    if (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread())
+    {
+      return "Main thread";
+    }
+    const QString name = thread->objectName().isEmpty() ? QString("Thread") : thread->objectName();
+    return QString("%1 %2").arg(name).arg(id);
+  }
+
+} // anonymous namespace end
+
+void Tracer::start(const QString& fileName)
+{
+  QMutexLocker locker(&traceMutex);
+  sRecording.store(0);
+  threadBuffers.clear();
+  traceFileName = fileName;
+  traceError.clear();
+  currentRecording.ref();
+  traceClock.start();
+  sRecording.store(1);
+}
+
+bool Tracer::stop()
+{
+  QMutexLocker locker(&traceMutex);
+  sRecording.store(0);
+  const qint64 pid = QCoreApplication::applicationPid();
+  QJsonArray traceEvents;
+  for (const QSharedPointer<ThreadBuffer>& buffer : threadBuffers)
+  {
+    QVector<Event> events;
+    {
+      QMutexLocker bufferLocker(&buffer->mutex);
+      events.swap(buffer->events);
+    }
+    traceEvents << QJsonObject {{"name", "thread_name"}, {"ph", "M"}, {"pid", double(pid)}, {"tid", buffer->id},
+                                {"args", QJsonObject {{"name", buffer->name}}}};
+    // Times are in microseconds
+    for (const Event& event : events)
+    {
+      traceEvents << QJsonObject {{"name", event.name}, {"cat", "binary-encoding"}, {"ph", "X"},
+                                  {"ts", event.begin / 1e3}, {"dur", (event.end - event.begin) / 1e3},
+                                  {"pid", double(pid)}, {"tid", buffer->id}};
+    }
+  }
+  threadBuffers.clear();
+  const QJsonObject trace {{"traceEvents", traceEvents}, {"displayTimeUnit", "ms"}};
+  QSaveFile file(traceFileName);
+  if (!file.open(QIODevice::WriteOnly) || file.write(QJsonDocument(trace).toJson(QJsonDocument::Compact)) < 0 ||
+      !file.commit())
+  {
+    traceError = file.errorString();
+    return false;
+  }
+  return true;
+}
+
+QString Tracer::errorString()
+{
+  QMutexLocker locker(&traceMutex);
+  return traceError;
+}
+
+qint64 Tracer::now()
+{
+  return traceClock.nsecsElapsed();
+}
+
+void Tracer::record(const char* name, qint64 begin, qint64 end)
+{
+  if (!threadBuffer)
+  {
+    threadBuffer.reset(new ThreadBuffer);
+  }
+  ThreadBuffer& buffer = *threadBuffer;
+  if (buffer.recording != currentRecording.load())
+  { // The first span of this thread in the recording, the only time the threads meet
+    QMutexLocker locker(&traceMutex);
+    if (!isRecording())
+    {
+      return;
+    }
+    QMutexLocker bufferLocker(&buffer.mutex);
+    buffer.events.clear();
+    buffer.recording = currentRecording.load();
+    buffer.id = threadBuffers.size();
+    buffer.name = threadName(buffer.id);
+    threadBuffers << threadBuffer;
+  }
+  QMutexLocker bufferLocker(&buffer.mutex);
+  if (isRecording())
+  { // Otherwise stopped while the span was open
+    buffer.events << Event {name, begin, end};
+  }
+}
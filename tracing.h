@@ -0,0 +1,79 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2015 Christian González León
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+  */
+
+#ifndef TRACING_H
+#define TRACING_H
+
+#include <QAtomicInt>
+#include <QString>
+
+namespace chrishenx {
+
+  // Records spans of time as Chrome trace events, to be loaded in chrome://tracing or Perfetto.
+  // The spans are compiled in everywhere but cost one atomic load while nothing is being recorded.
+  // Every thread is a row of its own in the timeline, its spans are kept apart from the other
+  // threads' until stop() merges them
+  class Tracer
+  {
+  public:
+    // Starts recording, stop() writes what was recorded to fileName
+    static void start(const QString& fileName);
+    // Returns false on failure and errorString() says why
+    static bool stop();
+    static QString errorString();
+
+    static bool isRecording() { return sRecording.load() != 0; }
+    static qint64 now(); // ns since start()
+    // name must outlive the recording, string literals do
+    static void record(const char* name, qint64 begin, qint64 end);
+
+  private:
+    static QAtomicInt sRecording;
+  };
+
+  // The span from its construction to its destruction, when recording
+  class TraceScope
+  {
+  public:
+    explicit TraceScope(const char* name)
+      : mName(Tracer::isRecording() ? name : nullptr), mBegin(mName ? Tracer::now() : 0) {}
+    ~TraceScope()
+    {
+      if (mName)
+      {
+        Tracer::record(mName, mBegin, Tracer::now());
+      }
+    }
+
+  private:
+    Q_DISABLE_COPY(TraceScope)
+
+    const char* mName;
+    qint64 mBegin;
+  };
+
+} // chrishenx namespace end
+
+
+#endif // TRACING_H
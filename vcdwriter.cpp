@@ -0,0 +1,252 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2015 Christian González León
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+  */
+
+#include "vcdwriter.h"
+
+#include <charconv>
+#include <cstring>
+#include <limits>
+
+using namespace chrishenx;
+
+namespace {
+
+  struct TimeUnit
+  {
+    const char* name;
+    double seconds;
+  };
+
+  const TimeUnit TIME_UNITS[] = {
+    {"1 s", 1}, {"100 ms", 1e-1}, {"10 ms", 1e-2}, {"1 ms", 1e-3}, {"100 us", 1e-4},
+    {"10 us", 1e-5}, {"1 us", 1e-6}, {"100 ns", 1e-7}, {"10 ns", 1e-8}, {"1 ns", 1e-9},
+    {"100 ps", 1e-10}, {"10 ps", 1e-11}, {"1 ps", 1e-12}, {"100 fs", 1e-13}, {"10 fs", 1e-14},
+    {"1 fs", 1e-15}
+  };
+
+  const int MAX_TIME_SIZE = 24; // '#', 19 digits and the new line
+  const double MAX_ROUNDING = 0.01; // Of half a bit period, for the edges between time units
+
+  int wireWidth(int levelCount)
+  {
+    int width = 1;
+    while ((1 << width) < levelCount)
+    {
+      ++width;
+    }
+    return width;
+  }
+
+} // anonymous namespace end
+
+VcdWriter::VcdWriter(QIODevice* device)
+  : mDevice(device), mBuffer(BUFFER_SIZE, Qt::Uninitialized)
+{
+}
+
+bool VcdWriter::begin(double transSpeed, double amplitude, qint64 bitCount,
+                      const QVector<WaveformTrack>& tracks, const QList<QByteArray>& names)
+{
+  mUsed = 0;
+  mFailed = false;
+  mError.clear();
+  mLastTime = -1;
+  mTracks.clear();
+
+  // Half a bit period in the largest unit that makes it whole or, when none does, in the largest
+  // one rounding the edges by less than MAX_ROUNDING of it
+  const double tickSeconds = 0.5 / transSpeed;
+  const TimeUnit* unit = nullptr;
+  for (const TimeUnit& candidate : TIME_UNITS)
+  {
+    const double units = tickSeconds / candidate.seconds;
+    if (units >= 1 && qAbs(units - qRound64(units)) < 1e-6)
+    {
+      unit = &candidate;
+      mUnitsPerTick = qRound64(units);
+      break;
+    }
+    if (!unit && 0.5 / units < MAX_ROUNDING)
+    {
+      unit = &candidate;
+      mUnitsPerTick = units;
+    }
+  }
+  // Finer units only make the times larger
+  if (!unit || mUnitsPerTick * 2 * bitCount >= double(std::numeric_limits<qint64>::max()))
+  {
+    mFailed = true;
+    mError = QString("%1 bits at %2 bps do not fit the times of a value change dump")
+             .arg(bitCount).arg(transSpeed);
+    return false;
+  }
+
+  QByteArray header = "$version binary-encoding $end\n$comment transmission speed ";
+  header += QByteArray::number(transSpeed) + " bps, amplitude " + QByteArray::number(amplitude) +
+            " V $end\n$timescale " + unit->name + " $end\n$scope module encoding $end\n";
+  for (int i = 0; i < tracks.size(); ++i)
+  {
+    TrackState state;
+    state.detector = EdgeDetector(tracks[i], transSpeed, amplitude);
+    state.width = wireWidth(state.detector.levelCount());
+    state.id = char('!' + i);
+    header += "$var wire " + QByteArray::number(state.width) + ' ' + state.id + ' ' + names[i] +
+              " $end\n";
+    mTracks << state;
+  }
+  header += "$upscope $end\n";
+  for (int i = 0; i < tracks.size(); ++i)
+  { // What the values of the wires stand for
+    header += "$comment " + names[i] + " levels:";
+    for (int level = 0; level < mTracks[i].detector.levelCount(); ++level)
+    {
+      header += ' ' + QByteArray::number(level) + " = " +
+                QByteArray::number(mTracks[i].detector.levelVolts(level)) + " V";
+    }
+    header += " $end\n";
+  }
+  header += "$enddefinitions $end\n";
+  write(header);
+  return !mFailed;
+}
+
+bool VcdWriter::append(const QVector<BinaryEncoder::Data>& pointsPerTrack)
+{
+  // An edge is written once no track can have an earlier one, the held back edges are the
+  // earliest that can still come
+  qint64 endTick = std::numeric_limits<qint64>::max();
+  for (int i = 0; i < mTracks.size(); ++i)
+  {
+    TrackState& track = mTracks[i];
+    track.detector.feed(pointsPerTrack[i], track.edges);
+    endTick = qMin(endTick, track.detector.hasPending() ? track.detector.pendingTick() : 0);
+  }
+  writeEdges(endTick);
+  return !mFailed;
+}
+
+bool VcdWriter::finish(qint64 bitCount)
+{
+  for (TrackState& track : mTracks)
+  {
+    track.detector.finish(track.edges);
+  }
+  writeEdges(std::numeric_limits<qint64>::max());
+  writeTime(qRound64(bitCount * 2 * mUnitsPerTick)); // The end of the last bit
+  return flush();
+}
+
+void VcdWriter::writeEdges(qint64 endTick)
+{
+  for (;;)
+  {
+    qint64 tick = endTick;
+    for (const TrackState& track : mTracks)
+    {
+      if (track.next < track.edges.size())
+      {
+        tick = qMin(tick, track.edges[track.next].tick);
+      }
+    }
+    if (tick == endTick)
+    {
+      break;
+    }
+    writeTime(qRound64(tick * mUnitsPerTick));
+    for (TrackState& track : mTracks)
+    {
+      if (track.next < track.edges.size() && track.edges[track.next].tick == tick)
+      {
+        const int level = track.edges[track.next++].level;
+        char* out = reserve(track.width + 3);
+        if (track.width == 1)
+        {
+          *out++ = char('0' + level);
+        }
+        else
+        {
+          *out++ = 'b';
+          for (int bit = track.width - 1; bit >= 0; --bit)
+          {
+            *out++ = char('0' + ((level >> bit) & 1));
+          }
+          *out++ = ' ';
+        }
+        *out++ = track.id;
+        *out++ = '\n';
+        mUsed = int(out - mBuffer.data());
+      }
+    }
+  }
+  for (TrackState& track : mTracks)
+  {
+    track.edges.remove(0, track.next);
+    track.next = 0;
+  }
+}
+
+void VcdWriter::writeTime(qint64 time)
+{
+  if (time <= mLastTime)
+  {
+    return;
+  }
+  mLastTime = time;
+  char* out = reserve(MAX_TIME_SIZE);
+  *out++ = '#';
+  out = std::to_chars(out, out + MAX_TIME_SIZE - 2, time).ptr;
+  *out++ = '\n';
+  mUsed = int(out - mBuffer.data());
+}
+
+char* VcdWriter::reserve(int size)
+{
+  if (mUsed + size > mBuffer.size())
+  {
+    flush();
+  }
+  return mBuffer.data() + mUsed;
+}
+
+void VcdWriter::write(const QByteArray& text)
+{
+  if (text.size() > mBuffer.size())
+  {
+    flush();
+    mFailed = mFailed || mDevice->write(text) != text.size();
+    return;
+  }
+  std::memcpy(reserve(text.size()), text.constData(), size_t(text.size()));
+  mUsed += text.size();
+}
+
+bool VcdWriter::flush()
+{
+  if (mUsed > 0 && !mFailed)
+  {
+    mFailed = mDevice->write(mBuffer.constData(), mUsed) != mUsed;
+  }
+  mUsed = 0;
+  return !mFailed;
+}
@@ -0,0 +1,88 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2015 Christian González León
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+  */
+
+#ifndef VCDWRITER_H
+#define VCDWRITER_H
+
+#include "waveformfile.h"
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+namespace chrishenx {
+
+  // Streams the encodings of a message as a value change dump (IEEE 1364 VCD) that logic analyzer
+  // and waveform viewers open. Every method is a wire, one bit wide when it has two levels and
+  // otherwise wide enough for the index of its level, written only when it changes. The time unit
+  // is the largest one that divides half a bit period, where every edge falls, or else the largest
+  // one fine enough for the rounded edges. The text is formatted straight into a large buffer and
+  // written to the device a buffer at a time
+  class VcdWriter
+  {
+  public:
+    static const int BUFFER_SIZE = 1 << 22;
+
+    explicit VcdWriter(QIODevice* device);
+
+    // All of them return false on failure and errorString() says why
+    bool begin(double transSpeed, double amplitude, qint64 bitCount,
+               const QVector<WaveformTrack>& tracks, const QList<QByteArray>& names);
+    // The points of every track for the same bits, the bits going on from the ones appended before
+    bool append(const QVector<BinaryEncoder::Data>& pointsPerTrack);
+    bool finish(qint64 bitCount);
+    QString errorString() const { return mError.isEmpty() ? mDevice->errorString() : mError; }
+
+  private:
+    struct TrackState
+    {
+      EdgeDetector detector;
+      QVector<EdgeDetector::Edge> edges; // Not written yet
+      int next = 0; // First edge not written
+      int width; // In bits of the wire
+      char id;
+    };
+
+    QIODevice* mDevice;
+    QByteArray mBuffer;
+    int mUsed = 0;
+    bool mFailed = false;
+    QString mError; // When the failure was not the device's
+    double mUnitsPerTick = 1; // Time units in half a bit period
+    qint64 mLastTime = -1;
+    QVector<TrackState> mTracks;
+
+    void writeEdges(qint64 endTick); // Up to endTick, not included
+    void writeTime(qint64 time);
+    char* reserve(int size); // Room at the end of the buffer, flushing it first if needed
+    void write(const QByteArray& text);
+    bool flush();
+  };
+
+} // chrishenx namespace end
+
+
+#endif // VCDWRITER_H
@@ -0,0 +1,468 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2015 Christian González León
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+  */
+
+#include "waveformfile.h"
+
+#include <QtEndian>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace chrishenx;
+
+namespace {
+
+  const char HEADER_MAGIC[4] = {'B', 'E', 'W', '1'};
+  const char INDEX_MAGIC[4] = {'B', 'E', 'W', 'I'};
+  const qint64 HEADER_SIZE = 36; // Without the tracks
+  const qint64 TRACK_SIZE = 4;
+  const qint64 INDEX_ENTRY_SIZE = 32;
+  const qint64 FOOTER_SIZE = 16;
+  const int ENVELOPE_GROUPS = 2048; // Min/max pairs in an envelope at most
+
+  // The levels of a method go evenly from this to the amplitude
+  double lowLevel(BinaryEncoder::Method method, double amplitude)
+  {
+    return method == BinaryEncoder::Method::TTL || method == BinaryEncoder::Method::CLOCK ? 0 : -amplitude;
+  }
+
+  template <typename T>
+  void put(QByteArray& bytes, T value)
+  {
+    value = qToLittleEndian(value);
+    bytes.append(reinterpret_cast<const char*>(&value), int(sizeof(T)));
+  }
+
+  void putDouble(QByteArray& bytes, double value)
+  {
+    quint64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    put(bytes, bits);
+  }
+
+  void putVarint(QByteArray& bytes, quint64 value)
+  {
+    while (value >= 0x80)
+    {
+      bytes += char(value | 0x80);
+      value >>= 7;
+    }
+    bytes += char(value);
+  }
+
+  template <typename T>
+  T get(const uchar*& data)
+  {
+    const T value = qFromLittleEndian<T>(data);
+    data += sizeof(T);
+    return value;
+  }
+
+  double getDouble(const uchar*& data)
+  {
+    const quint64 bits = get<quint64>(data);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  quint64 getVarint(const uchar*& data, const uchar* end)
+  {
+    quint64 value = 0;
+    for (int shift = 0; data < end && shift < 64; shift += 7)
+    {
+      const uchar byte = *data++;
+      value |= quint64(byte & 0x7F) << shift;
+      if (!(byte & 0x80))
+      {
+        break;
+      }
+    }
+    return value;
+  }
+
+} // anonymous namespace end
+
+int chrishenx::levelCount(const WaveformTrack& track)
+{
+  switch (track.method)
+  {
+  case BinaryEncoder::Method::BIPOLAR:
+  case BinaryEncoder::Method::PSEUDOTERNARY:
+    return 3;
+  case BinaryEncoder::Method::MULTILEVEL:
+    return track.levels;
+  default:
+    return 2;
+  }
+}
+
+EdgeDetector::EdgeDetector(const WaveformTrack& track, double transSpeed, double amplitude)
+  : mTicksPerSecond(transSpeed * 2),
+    mLowLevel(lowLevel(track.method, amplitude)),
+    mLevelCount(chrishenx::levelCount(track))
+{
+  mLevelScale = (mLevelCount - 1) / (amplitude - mLowLevel);
+}
+
+void EdgeDetector::feed(const BinaryEncoder::Data& points, QVector<Edge>& edges)
+{
+  for (const BinaryEncoder::Point& point : points)
+  {
+    const Edge edge {qRound64(point.first * mTicksPerSecond),
+                     qBound(0, qRound((point.second - mLowLevel) * mLevelScale), mLevelCount - 1)};
+    if (mHasPending && edge.tick == mPending.tick)
+    { // The far end of a vertical edge, the level that stays is the last one
+      mPending.level = edge.level;
+      continue;
+    }
+    if (mHasPending && edge.level == mPending.level)
+    { // The end of a level
+      continue;
+    }
+    if (mHasPending)
+    {
+      settle(mPending, edges);
+    }
+    mPending = edge;
+    mHasPending = true;
+  }
+}
+
+void EdgeDetector::finish(QVector<Edge>& edges)
+{
+  if (mHasPending)
+  {
+    settle(mPending, edges);
+    mHasPending = false;
+  }
+}
+
+void EdgeDetector::settle(const Edge& edge, QVector<Edge>& edges)
+{
+  if (edge.level != mLastLevel)
+  { // Otherwise a vertical edge that came back to where it started
+    edges << edge;
+    mLastLevel = edge.level;
+  }
+}
+
+bool WaveformFileWriter::begin(double transSpeed, double amplitude, qint64 bitCount,
+                               const QVector<WaveformTrack>& tracks)
+{
+  mOffset = 0;
+  mTracks.clear();
+  mIndex.clear();
+  QByteArray header(HEADER_MAGIC, sizeof(HEADER_MAGIC));
+  put(header, VERSION);
+  putDouble(header, transSpeed);
+  putDouble(header, amplitude);
+  put(header, bitCount);
+  put(header, quint32(tracks.size()));
+  for (const WaveformTrack& track : tracks)
+  {
+    TrackState state;
+    state.detector = EdgeDetector(track, transSpeed, amplitude);
+    mTracks << state;
+    put(header, quint8(track.method));
+    put(header, quint8(levelCount(track)));
+    put(header, quint16(0));
+  }
+  return write(header);
+}
+
+bool WaveformFileWriter::append(int track, const BinaryEncoder::Data& points)
+{
+  TrackState& state = mTracks[track];
+  state.detector.feed(points, state.edges);
+  return writeChunks(track, false);
+}
+
+bool WaveformFileWriter::finish()
+{
+  for (int track = 0; track < mTracks.size(); ++track)
+  {
+    mTracks[track].detector.finish(mTracks[track].edges);
+    if (!writeChunks(track, true))
+    {
+      return false;
+    }
+  }
+  const qint64 indexOffset = mOffset;
+  QByteArray index;
+  index.reserve(int(8 + mIndex.size() * INDEX_ENTRY_SIZE + FOOTER_SIZE));
+  put(index, qint64(mIndex.size()));
+  for (const ChunkEntry& entry : mIndex)
+  {
+    put(index, entry.track);
+    put(index, entry.edgeCount);
+    put(index, entry.firstTick);
+    put(index, entry.offset);
+    put(index, entry.size);
+    put(index, entry.minLevel);
+    put(index, entry.maxLevel);
+    put(index, quint16(0));
+  }
+  put(index, indexOffset);
+  index.append(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+  put(index, quint32(0));
+  return write(index);
+}
+
+bool WaveformFileWriter::write(const QByteArray& bytes)
+{
+  if (mDevice->write(bytes) != bytes.size())
+  {
+    return false;
+  }
+  mOffset += bytes.size();
+  return true;
+}
+
+bool WaveformFileWriter::writeChunks(int track, bool last)
+{
+  QVector<EdgeDetector::Edge>& edges = mTracks[track].edges;
+  int from = 0;
+  while (edges.size() - from >= EDGES_PER_CHUNK || (last && from < edges.size()))
+  {
+    const int count = qMin(int(EDGES_PER_CHUNK), edges.size() - from);
+    if (!writeChunk(track, from, count))
+    {
+      return false;
+    }
+    from += count;
+  }
+  edges.remove(0, from);
+  return true;
+}
+
+bool WaveformFileWriter::writeChunk(int track, int from, int count)
+{
+  const EdgeDetector::Edge* edges = mTracks[track].edges.constData() + from;
+  QByteArray chunk;
+  chunk.reserve(count * 3);
+  quint8 minLevel = 0xFF;
+  quint8 maxLevel = 0;
+  for (int i = 0; i < count; ++i)
+  {
+    chunk += char(edges[i].level);
+    minLevel = qMin(minLevel, quint8(edges[i].level));
+    maxLevel = qMax(maxLevel, quint8(edges[i].level));
+  }
+  for (int i = 1; i < count; ++i)
+  {
+    putVarint(chunk, quint64(edges[i].tick - edges[i - 1].tick));
+  }
+  mIndex << ChunkEntry {quint32(track), quint32(count), edges[0].tick, mOffset,
+                        quint32(chunk.size()), minLevel, maxLevel};
+  return write(chunk);
+}
+
+bool WaveformFileReader::open()
+{
+  mError.clear();
+  mTracks.clear();
+  mChunks.clear();
+  if (!mFile.map(MappedFile::Access::RANDOM))
+  {
+    return false;
+  }
+  const uchar* data = mFile.data();
+  const qint64 size = mFile.size();
+  if (size < HEADER_SIZE + FOOTER_SIZE || memcmp(data, HEADER_MAGIC, sizeof(HEADER_MAGIC)) != 0)
+  {
+    return fail("not a waveform file");
+  }
+  const uchar* header = data + sizeof(HEADER_MAGIC);
+  if (get<quint32>(header) != WaveformFileWriter::VERSION)
+  {
+    return fail("unsupported waveform file version");
+  }
+  mTransSpeed = getDouble(header);
+  mAmplitude = getDouble(header);
+  mBitCount = get<qint64>(header);
+  const quint32 trackCount = get<quint32>(header);
+  const qint64 headerSize = HEADER_SIZE + trackCount * TRACK_SIZE;
+  if (headerSize + FOOTER_SIZE > size || mTransSpeed <= 0 || mAmplitude <= 0)
+  {
+    return fail("corrupted waveform file header");
+  }
+  for (quint32 i = 0; i < trackCount; ++i)
+  {
+    const quint8 method = get<quint8>(header);
+    const quint8 levels = get<quint8>(header);
+    header += 2;
+    if (method > quint8(BinaryEncoder::Method::CLOCK) || levels < 2)
+    {
+      return fail("corrupted waveform file header");
+    }
+    mTracks << WaveformTrack {BinaryEncoder::Method(method), levels};
+  }
+
+  const uchar* footer = data + size - FOOTER_SIZE;
+  const qint64 indexOffset = get<qint64>(footer);
+  if (memcmp(footer, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 || indexOffset < headerSize ||
+      indexOffset + 8 > size - FOOTER_SIZE)
+  {
+    return fail("unfinished or corrupted waveform file");
+  }
+  const uchar* index = data + indexOffset;
+  const qint64 chunkCount = get<qint64>(index);
+  if (chunkCount < 0 || chunkCount > (size - FOOTER_SIZE - indexOffset - 8) / INDEX_ENTRY_SIZE)
+  {
+    return fail("corrupted waveform file index");
+  }
+  mChunks.resize(int(trackCount));
+  for (qint64 i = 0; i < chunkCount; ++i)
+  {
+    const quint32 track = get<quint32>(index);
+    ChunkEntry entry;
+    entry.edgeCount = get<quint32>(index);
+    entry.firstTick = get<qint64>(index);
+    entry.offset = get<qint64>(index);
+    entry.size = get<quint32>(index);
+    entry.minLevel = get<quint8>(index);
+    entry.maxLevel = get<quint8>(index);
+    index += 2;
+    if (track >= trackCount || entry.offset < headerSize || entry.offset + entry.size > indexOffset ||
+        entry.edgeCount == 0 || entry.edgeCount > entry.size)
+    {
+      return fail("corrupted waveform file index");
+    }
+    mChunks[int(track)] << entry;
+  }
+  return true;
+}
+
+BinaryEncoder::Data WaveformFileReader::points(int track, double from, double to) const
+{
+  BinaryEncoder::Data points;
+  const QVector<ChunkEntry>& chunks = mChunks[track];
+  if (chunks.isEmpty())
+  {
+    return points;
+  }
+  const double ticksPerSecond = mTransSpeed * 2;
+  // Last chunk starting at or before tick, or the first one
+  auto chunkAt = [&chunks](double tick)
+  {
+    auto after = std::upper_bound(chunks.constBegin(), chunks.constEnd(), tick,
+                                  [](double t, const ChunkEntry& chunk) { return t < chunk.firstTick; });
+    return qMax(0, int(after - chunks.constBegin()) - 1);
+  };
+  const int first = chunkAt(std::floor(from * ticksPerSecond));
+  const int last = chunkAt(std::ceil(to * ticksPerSecond));
+  const qint64 endTick = last + 1 < chunks.size() ? chunks[last + 1].firstTick : mBitCount * 2;
+
+  if (last - first + 1 > MAX_DECODED_CHUNKS)
+  { // Zoomed out, every group of chunks becomes a stroke between its lowest and highest levels
+    const int stride = qMax(1, (last - first + 1) / ENVELOPE_GROUPS);
+    points.reserve((last - first + 1) / stride * 2 + 2);
+    for (int c = first; c <= last; c += stride)
+    {
+      quint8 minLevel = 0xFF;
+      quint8 maxLevel = 0;
+      for (int g = c; g < qMin(c + stride, last + 1); ++g)
+      {
+        minLevel = qMin(minLevel, chunks[g].minLevel);
+        maxLevel = qMax(maxLevel, chunks[g].maxLevel);
+      }
+      const double t = chunks[c].firstTick / ticksPerSecond;
+      points << std::make_pair(t, level(track, maxLevel)) << std::make_pair(t, level(track, minLevel));
+    }
+    points << std::make_pair(endTick / ticksPerSecond, points.last().second);
+    return points;
+  }
+
+  quint32 edgeCount = 0;
+  for (int c = first; c <= last; ++c)
+  {
+    edgeCount += chunks[c].edgeCount;
+  }
+  points.reserve(int(edgeCount) * 2);
+  for (int c = first; c <= last; ++c)
+  {
+    const ChunkEntry& chunk = chunks[c];
+    const uchar* levels = mFile.data() + chunk.offset;
+    const uchar* delta = levels + chunk.edgeCount;
+    const uchar* end = levels + chunk.size;
+    qint64 tick = chunk.firstTick;
+    for (quint32 i = 0; i < chunk.edgeCount; ++i)
+    {
+      if (i > 0)
+      {
+        tick += qint64(getVarint(delta, end));
+      }
+      const double t = tick / ticksPerSecond;
+      if (!points.isEmpty())
+      { // Where the previous level ends
+        points << std::make_pair(t, points.last().second);
+      }
+      points << std::make_pair(t, level(track, levels[i]));
+    }
+  }
+  points << std::make_pair(endTick / ticksPerSecond, points.last().second);
+  return points;
+}
+
+double WaveformFileReader::level(int track, int index) const
+{
+  const WaveformTrack& info = mTracks[track];
+  const double low = lowLevel(info.method, mAmplitude);
+  return low + index * (mAmplitude - low) / (levelCount(info) - 1);
+}
+
+bool WaveformFileReader::fail(const QString& error)
+{
+  mError = error;
+  mFile.unmap();
+  return false;
+}
+
+bool chrishenx::writeWaveformFile(QIODevice* device, const BitBuffer& bits, double transSpeed,
+                                  double amplitude, const QVector<WaveformTrack>& tracks)
+{
+  WaveformFileWriter writer(device);
+  if (!writer.begin(transSpeed, amplitude, bits.size(), tracks))
+  {
+    return false;
+  }
+  BinaryEncoder encoder(bits, transSpeed, amplitude);
+  for (int track = 0; track < tracks.size(); ++track)
+  {
+    // A closing point in the middle lands on the tick of the next range and is replaced by it
+    for (qint64 first = 0; first < bits.size(); first += WaveformFileWriter::EDGES_PER_CHUNK)
+    {
+      const BinaryEncoder::Data points = encoder.encodeRange(tracks[track].method, first,
+                                                             WaveformFileWriter::EDGES_PER_CHUNK,
+                                                             tracks[track].levels);
+      if (!writer.append(track, points))
+      {
+        return false;
+      }
+    }
+  }
+  return writer.finish();
+}
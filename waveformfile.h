@@ -0,0 +1,184 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2015 Christian González León
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+  */
+
+#ifndef WAVEFORMFILE_H
+#define WAVEFORMFILE_H
+
+#include "binaryencoder.h"
+#include "mappedfile.h"
+
+#include <QIODevice>
+#include <QVector>
+
+namespace chrishenx {
+
+  // Binary waveform files (.bew) hold the encodings of one message with several methods, the
+  // tracks. A waveform is stored as its edges, the tick where a level starts and the index of that
+  // level, a tick being half a bit period so every edge of every method falls on one. All numbers
+  // are little endian:
+  //
+  //   header  "BEW1", quint32 version, double transSpeed, double amplitude, qint64 bitCount,
+  //           quint32 trackCount, then per track quint8 method, quint8 levelCount, quint16 0
+  //   chunks  EDGES_PER_CHUNK edges of one track (fewer in its last chunk), their level indexes
+  //           as bytes followed by the tick deltas from the previous edge as LEB128 varints
+  //   index   qint64 chunkCount, then per chunk quint32 track, quint32 edgeCount, qint64 firstTick,
+  //           qint64 offset, quint32 size, quint8 minLevel, quint8 maxLevel, quint16 0
+  //   footer  qint64 index offset, "BEWI", quint32 0
+  struct WaveformTrack
+  {
+    BinaryEncoder::Method method;
+    int levels; // Multilevel levels, ignored by the other methods
+  };
+
+  int levelCount(const WaveformTrack& track); // Of the levels the method moves between
+
+  // Turns the points of a waveform into its edges. The newest edge is held back, a point at its
+  // same tick may still change its level
+  class EdgeDetector
+  {
+  public:
+    struct Edge
+    {
+      qint64 tick;
+      int level;
+    };
+
+    EdgeDetector() {}
+    EdgeDetector(const WaveformTrack& track, double transSpeed, double amplitude);
+
+    // Appends the edges settled by points, which go on from the points fed before
+    void feed(const BinaryEncoder::Data& points, QVector<Edge>& edges);
+    void finish(QVector<Edge>& edges); // Appends the edge held back
+    bool hasPending() const { return mHasPending; }
+    qint64 pendingTick() const { return mPending.tick; }
+    int levelCount() const { return mLevelCount; }
+    double levelVolts(int level) const { return mLowLevel + level / mLevelScale; }
+
+  private:
+    double mTicksPerSecond = 0;
+    double mLowLevel = 0;
+    double mLevelScale = 0;
+    int mLevelCount = 2;
+    Edge mPending;
+    bool mHasPending = false;
+    int mLastLevel = -1; // Of the last edge settled
+
+    void settle(const Edge& edge, QVector<Edge>& edges);
+  };
+
+  // Streams a file to any device, seekable or not. The points of every track are appended in
+  // order, in pieces of any size and with the tracks interleaved at will
+  class WaveformFileWriter
+  {
+  public:
+    static const int EDGES_PER_CHUNK = 1 << 16;
+    static const quint32 VERSION = 1;
+
+    explicit WaveformFileWriter(QIODevice* device) : mDevice(device) {}
+
+    bool begin(double transSpeed, double amplitude, qint64 bitCount, const QVector<WaveformTrack>& tracks);
+    bool append(int track, const BinaryEncoder::Data& points);
+    bool finish(); // Writes what is pending and the index
+
+  private:
+    struct TrackState
+    {
+      EdgeDetector detector;
+      QVector<EdgeDetector::Edge> edges; // Not written yet
+    };
+
+    struct ChunkEntry
+    {
+      quint32 track;
+      quint32 edgeCount;
+      qint64 firstTick;
+      qint64 offset;
+      quint32 size;
+      quint8 minLevel;
+      quint8 maxLevel;
+    };
+
+    QIODevice* mDevice;
+    qint64 mOffset = 0;
+    QVector<TrackState> mTracks;
+    QVector<ChunkEntry> mIndex;
+
+    bool write(const QByteArray& bytes);
+    bool writeChunks(int track, bool last); // Only full ones unless last
+    bool writeChunk(int track, int from, int count);
+  };
+
+  // Reads a file through a random access mapping, any window of a track is decoded from just
+  // the chunks under it so multi gigabyte files open at once
+  class WaveformFileReader
+  {
+  public:
+    // A window over more chunks than this is drawn from the index as a min/max envelope
+    static const int MAX_DECODED_CHUNKS = 8;
+
+    explicit WaveformFileReader(const QString& fileName) : mFile(fileName) {}
+
+    bool open(); // On failure errorString() says why
+    QString errorString() const { return mError.isEmpty() ? mFile.errorString() : mError; }
+
+    double transSpeed() const { return mTransSpeed; }
+    double amplitude() const { return mAmplitude; }
+    qint64 bitCount() const { return mBitCount; }
+    double timeMax() const { return mBitCount / mTransSpeed; }
+    const QVector<WaveformTrack>& tracks() const { return mTracks; }
+
+    // Points of track covering the window [from, to] in seconds, ready to plot
+    BinaryEncoder::Data points(int track, double from, double to) const;
+
+  private:
+    struct ChunkEntry
+    {
+      qint64 firstTick;
+      qint64 offset;
+      quint32 edgeCount;
+      quint32 size;
+      quint8 minLevel;
+      quint8 maxLevel;
+    };
+
+    MappedFile mFile;
+    QString mError;
+    double mTransSpeed = 0;
+    double mAmplitude = 0;
+    qint64 mBitCount = 0;
+    QVector<WaveformTrack> mTracks;
+    QVector<QVector<ChunkEntry>> mChunks; // Per track, by firstTick
+
+    double level(int track, int index) const;
+    bool fail(const QString& error);
+  };
+
+  // Encodes bits with every track and writes the whole file, a chunk at a time
+  bool writeWaveformFile(QIODevice* device, const BitBuffer& bits, double transSpeed, double amplitude,
+                         const QVector<WaveformTrack>& tracks);
+
+} // chrishenx namespace end
+
+
+#endif // WAVEFORMFILE_H
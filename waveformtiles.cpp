@@ -0,0 +1,236 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2015 Christian González León
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+  */
+
+#include "waveformtiles.h"
+
+#include <QDir>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace chrishenx;
+
+namespace {
+
+  const qint64 PIECE_BITS = 1 << 14; // Encoded at a time while rendering a tile
+  const int TRACE_MARGIN = 8; // px above and below the levels of a trace
+  const int MIN_GRID_SPACING = 8; // px between bit boundaries to draw them
+
+  const QRgb BACKGROUND = qRgb(255, 255, 255);
+  const QRgb GRID = qRgb(230, 230, 230);
+  const QRgb SEPARATOR = qRgb(160, 160, 160);
+  const QRgb CLOCK_LINE = qRgb(255, 0, 0);
+  const QRgb SIGNAL_LINE = qRgb(0, 0, 255);
+
+  // Lowest and highest levels of a trace within a pixel column
+  struct Column
+  {
+    double low = std::numeric_limits<double>::infinity();
+    double high = -std::numeric_limits<double>::infinity();
+  };
+
+  bool unipolar(BinaryEncoder::Method method)
+  {
+    return method == BinaryEncoder::Method::CLOCK || method == BinaryEncoder::Method::TTL;
+  }
+
+} // anonymous namespace end
+
+WaveformTileWriter::WaveformTileWriter(const BitBuffer& bits, double transSpeed, double amplitude)
+  : mEncoder(bits, transSpeed, amplitude)
+{
+}
+
+bool WaveformTileWriter::write(const QString& directory, qint64 width, const QVector<WaveformTrack>& tracks,
+                               const QStringList& titles)
+{
+  mError.clear();
+  if (mEncoder.bitCount() == 0 || tracks.isEmpty() || width < 1)
+  {
+    mError = "Nothing to render";
+    return false;
+  }
+  QVector<qint64> levelWidths {width};
+  while (levelWidths.first() > TILE_WIDTH)
+  {
+    levelWidths.prepend((levelWidths.first() + 1) / 2);
+  }
+  QVector<Tile> tiles;
+  QDir root(directory);
+  for (int level = 0; level < levelWidths.size(); ++level)
+  {
+    if (!root.mkpath(QString::number(level)))
+    {
+      mError = QString("Cannot create %1").arg(root.filePath(QString::number(level)));
+      return false;
+    }
+    for (qint64 column = 0; column * TILE_WIDTH < levelWidths[level]; ++column)
+    {
+      tiles << Tile {level, levelWidths[level], column};
+    }
+  }
+
+  // Checkpoints hold one multilevel level count, the other methods ignore it
+  int levels = BinaryEncoder::DEFAULT_LEVELS;
+  for (const WaveformTrack& track : tracks)
+  {
+    if (track.method == BinaryEncoder::Method::MULTILEVEL)
+    {
+      levels = track.levels;
+    }
+  }
+  mEncoder.buildCheckpoints(levels);
+  QAtomicInt failures(0);
+  QtConcurrent::blockingMap(tiles, [&](const Tile& tile)
+  {
+    const QString fileName = root.filePath(QString("%1/%2.png").arg(tile.level).arg(tile.column));
+    if (!renderTile(tile, tracks, levels, fileName))
+    {
+      failures.ref();
+    }
+  });
+  if (failures.load() > 0)
+  {
+    mError = QString("Cannot write %1 tiles").arg(failures.load());
+    return false;
+  }
+
+  QJsonArray levelArray;
+  for (qint64 levelWidth : levelWidths)
+  {
+    levelArray << QJsonObject {{"width", double(levelWidth)},
+                               {"columns", double((levelWidth + TILE_WIDTH - 1) / TILE_WIDTH)}};
+  }
+  QJsonArray traceArray;
+  for (int i = 0; i < tracks.size(); ++i)
+  {
+    traceArray << QJsonObject {{"title", titles.value(i)}, {"top", i * TRACE_HEIGHT},
+                               {"height", TRACE_HEIGHT}};
+  }
+  const QJsonObject description {
+    {"tileWidth", TILE_WIDTH},
+    {"height", tracks.size() * TRACE_HEIGHT},
+    {"bitCount", double(mEncoder.bitCount())},
+    {"bitPeriod", 1 / mEncoder.transSpeed()},
+    {"levels", levelArray},
+    {"traces", traceArray}
+  };
+  QSaveFile file(root.filePath("tiles.json"));
+  if (!file.open(QIODevice::WriteOnly) || file.write(QJsonDocument(description).toJson()) < 0 ||
+      !file.commit())
+  {
+    mError = file.errorString();
+    return false;
+  }
+  return true;
+}
+
+bool WaveformTileWriter::renderTile(const Tile& tile, const QVector<WaveformTrack>& tracks, int levels,
+                                    const QString& fileName) const
+{
+  const qint64 bitCount = mEncoder.bitCount();
+  const qint64 firstPixel = tile.column * TILE_WIDTH;
+  const int tileWidth = int(qMin(qint64(TILE_WIDTH), tile.levelWidth - firstPixel));
+  const double bitsPerPixel = double(bitCount) / tile.levelWidth;
+  const double pixelsPerSecond = tile.levelWidth / (bitCount / mEncoder.transSpeed());
+  QImage image(tileWidth, tracks.size() * TRACE_HEIGHT, QImage::Format_RGB32);
+  image.fill(BACKGROUND);
+
+  // Bit boundaries, when they are far enough apart
+  if (bitsPerPixel * MIN_GRID_SPACING <= 1)
+  {
+    for (qint64 bit = qint64(std::ceil(firstPixel * bitsPerPixel));
+         bit <= bitCount && bit / bitsPerPixel < firstPixel + tileWidth; ++bit)
+    {
+      const int x = int(qint64(bit / bitsPerPixel) - firstPixel);
+      for (int y = 0; x >= 0 && x < tileWidth && y < image.height(); ++y)
+      {
+        reinterpret_cast<QRgb*>(image.scanLine(y))[x] = GRID;
+      }
+    }
+  }
+
+  const qint64 firstBit = qMax(qint64(0), qint64(std::floor(firstPixel * bitsPerPixel)));
+  const qint64 endBit = qMin(bitCount, qint64(std::ceil((firstPixel + tileWidth) * bitsPerPixel)) + 1);
+  QVector<Column> columns(tileWidth);
+  BinaryEncoder::Data points;
+  for (int i = 0; i < tracks.size(); ++i)
+  {
+    const BinaryEncoder::Method method = tracks[i].method;
+    const int pointsPerBit = BinaryEncoder::pointsPerBit(method);
+    columns.fill(Column());
+    for (qint64 first = firstBit; first < endBit; first += PIECE_BITS)
+    {
+      const qint64 count = qMin(PIECE_BITS, endBit - first);
+      points.resize(int(count * pointsPerBit + 1));
+      points.resize(int(mEncoder.encodeRangeInto(method, first, count, levels, points.data())));
+      // A level holds from its point to the next one, or to the end of the piece
+      const double pieceEnd = (first + count) / mEncoder.transSpeed();
+      for (int p = 0; p < points.size(); ++p)
+      {
+        const double end = p + 1 < points.size() ? points[p + 1].first : pieceEnd;
+        const qint64 from = qMax(qint64(std::floor(points[p].first * pixelsPerSecond)), firstPixel);
+        const qint64 to = qMin(qint64(std::floor(end * pixelsPerSecond)), firstPixel + tileWidth - 1);
+        for (qint64 x = from; x <= to; ++x)
+        {
+          Column& column = columns[int(x - firstPixel)];
+          column.low = qMin(column.low, points[p].second);
+          column.high = qMax(column.high, points[p].second);
+        }
+      }
+    }
+
+    // Level to row within the trace, the same ranges as the plots
+    const double top = mEncoder.amplitude() * 1.08;
+    const double bottom = unipolar(method) ? -0.09 : -top;
+    const int traceTop = i * TRACE_HEIGHT;
+    const double rowsPerVolt = (TRACE_HEIGHT - 2 * TRACE_MARGIN) / (top - bottom);
+    const QRgb line = method == BinaryEncoder::Method::CLOCK ? CLOCK_LINE : SIGNAL_LINE;
+    for (int x = 0; x < tileWidth; ++x)
+    {
+      if (columns[x].low > columns[x].high)
+      {
+        continue;
+      }
+      const int highRow = traceTop + TRACE_MARGIN + int((top - columns[x].high) * rowsPerVolt) - LINE_WIDTH / 2;
+      const int lowRow = traceTop + TRACE_MARGIN + int((top - columns[x].low) * rowsPerVolt) + (LINE_WIDTH - 1) / 2;
+      for (int y = qMax(highRow, traceTop); y <= qMin(lowRow, traceTop + TRACE_HEIGHT - 1); ++y)
+      {
+        reinterpret_cast<QRgb*>(image.scanLine(y))[x] = line;
+      }
+    }
+    if (i > 0)
+    {
+      std::fill_n(reinterpret_cast<QRgb*>(image.scanLine(traceTop)), tileWidth, SEPARATOR);
+    }
+  }
+  return image.save(fileName, "PNG");
+}
@@ -0,0 +1,78 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2015 Christian González León
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+  */
+
+#ifndef WAVEFORMTILES_H
+#define WAVEFORMTILES_H
+
+#include "binaryencoder.h"
+#include "waveformfile.h"
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace chrishenx {
+
+  // Renders a stack of traces as a pyramid of PNG tiles for web viewers, so images of millions of
+  // pixels are never held whole. Level n of the pyramid is twice as wide as level n - 1, the last
+  // one is as wide as asked and level 0 fits in a tile. Tiles are TILE_WIDTH pixels wide and as tall
+  // as the stack, written to <directory>/<level>/<column>.png, and <directory>/tiles.json describes
+  // the levels and where every trace is.
+  //
+  // Every tile is rendered on the thread pool on its own. Its bits are encoded in pieces and reduced
+  // to the lowest and the highest level of every pixel column, which are drawn straight into the
+  // scan lines, so any zoom costs the same per pixel
+  class WaveformTileWriter
+  {
+  public:
+    static const int TILE_WIDTH = 256; // px
+    static const int TRACE_HEIGHT = 96; // px
+    static const int LINE_WIDTH = 2; // px
+
+    WaveformTileWriter(const BitBuffer& bits, double transSpeed, double amplitude);
+
+    // Returns false on failure and errorString() says why
+    bool write(const QString& directory, qint64 width, const QVector<WaveformTrack>& tracks,
+               const QStringList& titles);
+    QString errorString() const { return mError; }
+
+  private:
+    struct Tile
+    {
+      int level;
+      qint64 levelWidth; // px
+      qint64 column;
+    };
+
+    BinaryEncoder mEncoder;
+    QString mError;
+
+    bool renderTile(const Tile& tile, const QVector<WaveformTrack>& tracks, int levels,
+                    const QString& fileName) const;
+  };
+
+} // chrishenx namespace end
+
+
+#endif // WAVEFORMTILES_H
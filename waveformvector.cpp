@@ -0,0 +1,398 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2015 Christian González León
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+  */
+
+#include "waveformvector.h"
+
+#include <QList>
+#include <QPageSize>
+#include <QPainter>
+#include <QPainterPath>
+#include <QPdfWriter>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <charconv>
+#include <cmath>
+
+using namespace chrishenx;
+
+namespace {
+
+  const qint64 PIECE_BITS = 1 << 16; // Encoded and simplified at a time
+  const double TOLERANCE = 1; // px, narrower detail is merged
+  const int TRACE_MARGIN = 8; // px above and below the levels of a trace
+  const int TITLE_SIZE = 12; // px
+  const int BUFFER_SIZE = 1 << 20; // Bytes of SVG gathered before writing them
+  const int MAX_COORDINATE_SIZE = 24;
+  const double DOTS_PER_INCH = 96;
+
+  const QColor SEPARATOR(160, 160, 160);
+  const QColor CLOCK_LINE(255, 0, 0);
+  const QColor SIGNAL_LINE(0, 0, 255);
+
+  bool unipolar(BinaryEncoder::Method method)
+  {
+    return method == BinaryEncoder::Method::CLOCK || method == BinaryEncoder::Method::TTL;
+  }
+
+  // b can be dropped from a, b, c without changing the path
+  bool straight(const QPointF& a, const QPointF& b, const QPointF& c)
+  {
+    const QPointF d1 = b - a;
+    const QPointF d2 = c - b;
+    const double cross = d1.x() * d2.y() - d1.y() * d2.x();
+    const double dot = QPointF::dotProduct(d1, d2);
+    return dot > 0 && qAbs(cross) <= 1e-9 * dot;
+  }
+
+  // Hundredths of a pixel are more than enough, and whole ones are written as integers
+  char* writeCoordinate(char* out, double value)
+  {
+    value = std::round(value * 100) / 100;
+    if (value == double(qint64(value)))
+    {
+      return std::to_chars(out, out + MAX_COORDINATE_SIZE, qint64(value)).ptr;
+    }
+    return std::to_chars(out, out + MAX_COORDINATE_SIZE, value).ptr;
+  }
+
+} // anonymous namespace end
+
+PathSimplifier::PathSimplifier(double tolerance)
+  : mTolerance(tolerance)
+{
+}
+
+void PathSimplifier::add(const QPointF& point)
+{
+  const qint64 column = qint64(std::floor(point.x() / mTolerance));
+  if (mCount > 0 && column != mColumn)
+  {
+    flushColumn();
+  }
+  if (mCount == 0)
+  {
+    mColumn = column;
+    mFirst = point;
+    mMinY = mMaxY = point.y();
+  }
+  mMinY = qMin(mMinY, point.y());
+  mMaxY = qMax(mMaxY, point.y());
+  mLast = point;
+  ++mCount;
+}
+
+QVector<QPointF> PathSimplifier::takeSettled()
+{
+  QVector<QPointF> settled;
+  if (mPoints.size() > 1)
+  {
+    const QPointF last = mPoints.last();
+    mPoints.removeLast();
+    settled.swap(mPoints);
+    mPoints << last;
+    mSettled = settled.last();
+    mHasSettled = true;
+  }
+  return settled;
+}
+
+QVector<QPointF> PathSimplifier::finish()
+{
+  if (mCount > 0)
+  {
+    flushColumn();
+  }
+  QVector<QPointF> rest;
+  rest.swap(mPoints);
+  if (!rest.isEmpty())
+  {
+    mSettled = rest.last();
+    mHasSettled = true;
+  }
+  return rest;
+}
+
+void PathSimplifier::flushColumn()
+{
+  append(mFirst);
+  if (mCount > 1)
+  { // Through both extremes at the last x, the far one from where the column ends first
+    const double x = mLast.x();
+    const bool minFirst = mLast.y() - mMinY >= mMaxY - mLast.y();
+    append(QPointF(x, mFirst.y()));
+    append(QPointF(x, minFirst ? mMinY : mMaxY));
+    append(QPointF(x, minFirst ? mMaxY : mMinY));
+    append(mLast);
+  }
+  mCount = 0;
+}
+
+void PathSimplifier::append(const QPointF& point)
+{
+  if (mPoints.isEmpty())
+  {
+    if (!mHasSettled || mSettled != point)
+    {
+      mPoints << point;
+    }
+    return;
+  }
+  if (mPoints.last() == point)
+  {
+    return;
+  }
+  if (mPoints.size() > 1 ? straight(mPoints[mPoints.size() - 2], mPoints.last(), point)
+                         : mHasSettled && straight(mSettled, mPoints.last(), point))
+  {
+    mPoints.last() = point;
+  }
+  else
+  {
+    mPoints << point;
+  }
+}
+
+WaveformVectorWriter::WaveformVectorWriter(const BitBuffer& bits, double transSpeed, double amplitude)
+  : mEncoder(bits, transSpeed, amplitude)
+{
+}
+
+bool WaveformVectorWriter::writeSvg(QIODevice* device, qint64 width, const QVector<WaveformTrack>& tracks,
+                                    const QStringList& titles)
+{
+  mError.clear();
+  if (mEncoder.bitCount() == 0 || tracks.isEmpty() || width < 1)
+  {
+    mError = "Nothing to render";
+    return false;
+  }
+  const int levels = prepare(tracks);
+  const qint64 height = tracks.size() * TRACE_HEIGHT;
+  QByteArray text;
+  text += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+  text += QString("<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%1\" height=\"%2\" "
+                  "viewBox=\"0 0 %1 %2\">\n").arg(width).arg(height).toUtf8();
+  text += "<rect width=\"100%\" height=\"100%\" fill=\"white\"/>\n";
+  auto flush = [&](int reserve)
+  {
+    if (text.size() + reserve <= BUFFER_SIZE)
+    {
+      return true;
+    }
+    const bool written = device->write(text) == text.size();
+    text.clear();
+    return written;
+  };
+
+  bool written = true;
+  for (int i = 0; written && i < tracks.size(); ++i)
+  {
+    const int top = i * TRACE_HEIGHT;
+    if (i > 0)
+    {
+      text += QString("<line x1=\"0\" y1=\"%1\" x2=\"%2\" y2=\"%1\" stroke=\"%3\"/>\n")
+          .arg(top).arg(width).arg(SEPARATOR.name()).toUtf8();
+    }
+    text += QString("<text x=\"4\" y=\"%1\" font-family=\"sans-serif\" font-size=\"%2\">%3</text>\n")
+        .arg(top + TITLE_SIZE).arg(TITLE_SIZE).arg(titles.value(i).toHtmlEscaped()).toUtf8();
+    const QColor line = tracks[i].method == BinaryEncoder::Method::CLOCK ? CLOCK_LINE : SIGNAL_LINE;
+    text += QString("<path fill=\"none\" stroke=\"%1\" stroke-width=\"%2\" d=\"")
+        .arg(line.name()).arg(LINE_WIDTH).toUtf8();
+    // Horizontal and vertical segments, most of them, only need one coordinate
+    bool started = false;
+    QPointF previous;
+    written = tracePath(width, i, tracks[i], levels, [&](const QVector<QPointF>& points)
+    {
+      if (!flush(points.size() * (2 * MAX_COORDINATE_SIZE + 3)))
+      {
+        return false;
+      }
+      const int start = text.size();
+      text.resize(start + points.size() * (2 * MAX_COORDINATE_SIZE + 3));
+      char* out = text.data() + start;
+      for (const QPointF& point : points)
+      {
+        if (!started || (point.x() != previous.x() && point.y() != previous.y()))
+        {
+          *out++ = started ? 'L' : 'M';
+          out = writeCoordinate(out, point.x());
+          *out++ = ' ';
+          out = writeCoordinate(out, point.y());
+        }
+        else if (point.y() == previous.y())
+        {
+          *out++ = 'H';
+          out = writeCoordinate(out, point.x());
+        }
+        else
+        {
+          *out++ = 'V';
+          out = writeCoordinate(out, point.y());
+        }
+        started = true;
+        previous = point;
+      }
+      text.resize(int(out - text.data()));
+      return true;
+    });
+    text += "\"/>\n";
+  }
+  text += "</svg>\n";
+  if (!written || device->write(text) != text.size())
+  {
+    mError = device->errorString();
+    return false;
+  }
+  return true;
+}
+
+bool WaveformVectorWriter::writePdf(QIODevice* device, qint64 width, const QVector<WaveformTrack>& tracks,
+                                    const QStringList& titles)
+{
+  mError.clear();
+  if (mEncoder.bitCount() == 0 || tracks.isEmpty() || width < 1)
+  {
+    mError = "Nothing to render";
+    return false;
+  }
+  const int levels = prepare(tracks);
+  const qint64 height = tracks.size() * TRACE_HEIGHT;
+  QPdfWriter writer(device);
+  writer.setResolution(int(DOTS_PER_INCH));
+  writer.setPageSize(QPageSize(QSizeF(width / DOTS_PER_INCH, height / DOTS_PER_INCH), QPageSize::Inch));
+  writer.setPageMargins(QMarginsF());
+  QPainter painter(&writer);
+  if (!painter.isActive())
+  {
+    mError = device->errorString();
+    return false;
+  }
+  QFont font("sans-serif");
+  font.setPixelSize(TITLE_SIZE);
+  painter.setFont(font);
+  for (int i = 0; i < tracks.size(); ++i)
+  {
+    const int top = i * TRACE_HEIGHT;
+    if (i > 0)
+    {
+      painter.setPen(SEPARATOR);
+      painter.drawLine(QPointF(0, top), QPointF(width, top));
+    }
+    painter.setPen(Qt::black);
+    painter.drawText(QPointF(4, top + TITLE_SIZE), titles.value(i));
+    // One path per trace, which is what keeps the file small
+    QPainterPath path;
+    tracePath(width, i, tracks[i], levels, [&](const QVector<QPointF>& points)
+    {
+      for (const QPointF& point : points)
+      {
+        if (path.elementCount() == 0)
+        {
+          path.moveTo(point);
+        }
+        else
+        {
+          path.lineTo(point);
+        }
+      }
+      return true;
+    });
+    const QColor line = tracks[i].method == BinaryEncoder::Method::CLOCK ? CLOCK_LINE : SIGNAL_LINE;
+    painter.strokePath(path, QPen(line, LINE_WIDTH));
+  }
+  if (!painter.end())
+  {
+    mError = device->errorString();
+    return false;
+  }
+  return true;
+}
+
+int WaveformVectorWriter::prepare(const QVector<WaveformTrack>& tracks)
+{
+  // Checkpoints hold one multilevel level count, the other methods ignore it
+  int levels = BinaryEncoder::DEFAULT_LEVELS;
+  for (const WaveformTrack& track : tracks)
+  {
+    if (track.method == BinaryEncoder::Method::MULTILEVEL)
+    {
+      levels = track.levels;
+    }
+  }
+  mEncoder.buildCheckpoints(levels);
+  return levels;
+}
+
+template <typename Sink>
+bool WaveformVectorWriter::tracePath(qint64 width, int index, const WaveformTrack& track, int levels,
+                                     Sink sink) const
+{
+  const qint64 bitCount = mEncoder.bitCount();
+  const BinaryEncoder::Method method = track.method;
+  const int pointsPerBit = BinaryEncoder::pointsPerBit(method);
+  const double pixelsPerSecond = width / (bitCount / mEncoder.transSpeed());
+  // Level to row within the trace, the same ranges as the plots
+  const double top = mEncoder.amplitude() * 1.08;
+  const double bottom = unipolar(method) ? -0.09 : -top;
+  const double traceTop = index * TRACE_HEIGHT + TRACE_MARGIN;
+  const double rowsPerVolt = (TRACE_HEIGHT - 2 * TRACE_MARGIN) / (top - bottom);
+  auto simplifyPiece = [=](qint64 first)
+  {
+    const qint64 count = qMin(PIECE_BITS, bitCount - first);
+    BinaryEncoder::Data points(int(count * pointsPerBit + 1));
+    points.resize(int(mEncoder.encodeRangeInto(method, first, count, levels, points.data())));
+    PathSimplifier simplifier(TOLERANCE);
+    for (const BinaryEncoder::Point& point : points)
+    {
+      simplifier.add(QPointF(point.first * pixelsPerSecond, traceTop + (top - point.second) * rowsPerVolt));
+    }
+    return simplifier.finish();
+  };
+
+  // The pieces are simplified again as they are joined, which merges the ends of every two
+  const int ahead = 2 * QThreadPool::globalInstance()->maxThreadCount();
+  QList<QFuture<QVector<QPointF>>> pieces;
+  PathSimplifier path(TOLERANCE);
+  qint64 next = 0;
+  bool accepted = true;
+  while (accepted && (next < bitCount || !pieces.isEmpty()))
+  {
+    for (; next < bitCount && pieces.size() < ahead; next += PIECE_BITS)
+    {
+      const qint64 first = next;
+      pieces << QtConcurrent::run([=]() { return simplifyPiece(first); });
+    }
+    for (const QPointF& point : pieces.takeFirst().result())
+    {
+      path.add(point);
+    }
+    accepted = sink(path.takeSettled());
+  }
+  for (QFuture<QVector<QPointF>>& piece : pieces)
+  { // They use the encoder
+    piece.waitForFinished();
+  }
+  return accepted && sink(path.finish());
+}
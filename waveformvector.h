@@ -0,0 +1,105 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2015 Christian González León
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+  */
+
+#ifndef WAVEFORMVECTOR_H
+#define WAVEFORMVECTOR_H
+
+#include "binaryencoder.h"
+#include "waveformfile.h"
+
+#include <QIODevice>
+#include <QPointF>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace chrishenx {
+
+  // Simplifies a polyline for a given resolution. Points closer in x than tolerance are reduced to
+  // the first one, a vertical run through the levels they reach and the last one, and runs of
+  // points on a straight line to their ends, so vertical edges survive and the size of the path is
+  // bound by the detail that can be seen and not by the points fed
+  class PathSimplifier
+  {
+  public:
+    explicit PathSimplifier(double tolerance);
+
+    void add(const QPointF& point);
+    // Points no later point can change, taken out of the simplifier
+    QVector<QPointF> takeSettled();
+    // Ends the path and takes the points left
+    QVector<QPointF> finish();
+
+  private:
+    double mTolerance;
+    QVector<QPointF> mPoints; // Simplified, the last one can still be merged
+    QPointF mSettled; // Last point taken out, kept to merge the next ones with
+    bool mHasSettled = false;
+
+    // Points added to the current column
+    qint64 mColumn = 0;
+    int mCount = 0;
+    QPointF mFirst, mLast;
+    double mMinY = 0, mMaxY = 0;
+
+    void flushColumn();
+    void append(const QPointF& point);
+  };
+
+  // Renders a stack of traces as a vector figure, a path per trace. The paths are simplified for
+  // the figure's width in pixels, so the size of the file and the time to write it depend on the
+  // detail visible at that width. The pieces of a trace are encoded and simplified on the thread
+  // pool, a couple of them a thread ahead of the one being written
+  class WaveformVectorWriter
+  {
+  public:
+    static const int TRACE_HEIGHT = 96; // px
+    static const int LINE_WIDTH = 2; // px
+
+    WaveformVectorWriter(const BitBuffer& bits, double transSpeed, double amplitude);
+
+    // Return false on failure and errorString() says why
+    bool writeSvg(QIODevice* device, qint64 width, const QVector<WaveformTrack>& tracks,
+                  const QStringList& titles);
+    // The page is the figure at 96 pixels per inch
+    bool writePdf(QIODevice* device, qint64 width, const QVector<WaveformTrack>& tracks,
+                  const QStringList& titles);
+    QString errorString() const { return mError; }
+
+  private:
+    BinaryEncoder mEncoder;
+    QString mError;
+
+    // Builds the checkpoints the tracks need and returns their multilevel level count
+    int prepare(const QVector<WaveformTrack>& tracks);
+    // Feeds the simplified points of the track drawn at row index to sink in order, batch by
+    // batch, and returns false as soon as sink does
+    template <typename Sink>
+    bool tracePath(qint64 width, int index, const WaveformTrack& track, int levels, Sink sink) const;
+  };
+
+} // chrishenx namespace end
+
+
+#endif // WAVEFORMVECTOR_H
@@ -0,0 +1,345 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2015 Christian González León
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+  */
+
+#include "waveformwriter.h"
+
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <QtEndian>
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+using namespace chrishenx;
+
+namespace {
+
+  // The level holding at every sample time is the one of the last point not after it
+  template <typename Sample, typename Convert>
+  void renderSamples(const BinaryEncoder::Data& points, qint64 firstSample, qint64 sampleCount,
+                     double sampleRate, Sample* out, int stride, Convert convert)
+  {
+    Sample* sample = out;
+    int point = 0;
+    for (qint64 n = firstSample; n < firstSample + sampleCount; ++n)
+    {
+      const double t = (n + 0.5) / sampleRate;
+      while (point + 1 < points.size() && points[point + 1].first <= t)
+      {
+        ++point;
+      }
+      *sample = convert(points.isEmpty() ? 0 : points[point].second);
+      sample += stride;
+    }
+  }
+
+  const int MAX_NUMBER_SIZE = 24; // Of a double with 12 significant digits
+
+  char* writeNumber(char* out, double value)
+  {
+    // Levels and the times of slow signals are mostly whole, those are much faster as integers
+    if (qAbs(value) < 1e12 && value == double(qint64(value)))
+    {
+      return std::to_chars(out, out + MAX_NUMBER_SIZE, qint64(value)).ptr;
+    }
+    return std::to_chars(out, out + MAX_NUMBER_SIZE, value, std::chars_format::general, 12).ptr;
+  }
+
+  // Appends the rows of points to text. With edgesOnly the points that leave the level as it was,
+  // previousLevel before the first one, are skipped
+  void appendRows(QByteArray& text, const BinaryEncoder::Data& points, const QByteArray& label,
+                  char separator, bool edgesOnly, double previousLevel)
+  {
+    const int start = text.size();
+    text.resize(start + points.size() * (label.size() + 2 * MAX_NUMBER_SIZE + 3));
+    char* out = text.data() + start;
+    for (const BinaryEncoder::Point& point : points)
+    {
+      if (edgesOnly && point.second == previousLevel)
+      {
+        continue;
+      }
+      previousLevel = point.second;
+      std::memcpy(out, label.constData(), size_t(label.size()));
+      out += label.size();
+      *out++ = separator;
+      out = writeNumber(out, point.first);
+      *out++ = separator;
+      out = writeNumber(out, point.second);
+      *out++ = '\n';
+    }
+    text.resize(int(out - text.constData()));
+  }
+
+  template <typename T>
+  void put(QByteArray& bytes, T value)
+  {
+    value = qToLittleEndian(value);
+    bytes.append(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  quint32 riffSize(qint64 size)
+  {
+    return size > 0xFFFFFFFF ? 0xFFFFFFFF : quint32(size);
+  }
+
+} // anonymous namespace end
+
+QByteArray chrishenx::toVertices(const BinaryEncoder::Data& points)
+{
+  QByteArray vertices(points.size() * int(2 * sizeof(double)), Qt::Uninitialized);
+  double* vertex = reinterpret_cast<double*>(vertices.data());
+  for (const BinaryEncoder::Point& point : points)
+  {
+    *vertex++ = point.first;
+    *vertex++ = point.second;
+  }
+  return vertices;
+}
+
+QByteArray chrishenx::toCsv(const BinaryEncoder::Data& points, const QByteArray& label, char separator)
+{
+  QByteArray csv;
+  appendRows(csv, points, label, separator, false, 0);
+  return csv;
+}
+
+QByteArray chrishenx::toPcm(const BinaryEncoder::Data& points, qint64 firstSample, qint64 sampleCount,
+                            double sampleRate, double amplitude)
+{
+  QByteArray pcm(int(sampleCount * sizeof(qint16)), Qt::Uninitialized);
+  writePcm(points, firstSample, sampleCount, sampleRate, amplitude, reinterpret_cast<qint16*>(pcm.data()));
+  return pcm;
+}
+
+void chrishenx::writePcm(const BinaryEncoder::Data& points, qint64 firstSample, qint64 sampleCount,
+                         double sampleRate, double amplitude, qint16* out, int stride)
+{
+  const double scale = 32767 / amplitude;
+  renderSamples(points, firstSample, sampleCount, sampleRate, out, stride, [=](double level)
+  {
+    return qint16(qBound(-32767, qRound(level * scale), 32767));
+  });
+}
+
+void chrishenx::writePcm(const BinaryEncoder::Data& points, qint64 firstSample, qint64 sampleCount,
+                         double sampleRate, double amplitude, float* out, int stride)
+{
+  renderSamples(points, firstSample, sampleCount, sampleRate, out, stride, [=](double level)
+  {
+    return float(qBound(-1.0, level / amplitude, 1.0));
+  });
+}
+
+QByteArray chrishenx::interleavePcm(const QList<QByteArray>& channels)
+{
+  if (channels.size() == 1)
+  {
+    return channels.first();
+  }
+  const int channelCount = channels.size();
+  const int frameCount = channels.isEmpty() ? 0 : channels.first().size() / int(sizeof(qint16));
+  QByteArray pcm(frameCount * channelCount * int(sizeof(qint16)), Qt::Uninitialized);
+  qint16* frame = reinterpret_cast<qint16*>(pcm.data());
+  for (int c = 0; c < channelCount; ++c)
+  {
+    const qint16* sample = reinterpret_cast<const qint16*>(channels[c].constData());
+    for (int i = 0; i < frameCount; ++i)
+    {
+      frame[i * channelCount + c] = sample[i];
+    }
+  }
+  return pcm;
+}
+
+int chrishenx::sampleSize(SampleFormat format)
+{
+  return format == SampleFormat::INT16 ? int(sizeof(qint16)) : int(sizeof(float));
+}
+
+qint64 chrishenx::sampleAtBit(qint64 bit, double transSpeed, double sampleRate)
+{
+  // Sample n is taken at (n + 0.5) / sampleRate seconds
+  return qMax(qint64(0), qint64(std::ceil(bit * sampleRate / transSpeed - 0.5)));
+}
+
+QByteArray chrishenx::wavHeader(SampleFormat format, int channelCount, int sampleRate, qint64 frameCount)
+{
+  const bool floats = format == SampleFormat::FLOAT32;
+  const int frameSize = channelCount * sampleSize(format);
+  const qint64 dataSize = frameCount * frameSize;
+  // Non integer samples need the extension size in the format chunk and a fact chunk
+  const quint32 formatSize = floats ? 18 : 16;
+  const qint64 factSize = floats ? 12 : 0;
+  QByteArray header("RIFF");
+  put(header, riffSize(4 + 8 + formatSize + factSize + 8 + dataSize));
+  header += "WAVEfmt ";
+  put(header, formatSize);
+  put(header, quint16(floats ? 3 : 1)); // IEEE float or integer PCM
+  put(header, quint16(channelCount));
+  put(header, quint32(sampleRate));
+  put(header, quint32(qMin(qint64(sampleRate) * frameSize, qint64(0xFFFFFFFF)))); // Bytes per second
+  put(header, quint16(frameSize));
+  put(header, quint16(sampleSize(format) * 8));
+  if (floats)
+  {
+    put(header, quint16(0));
+    header += "fact";
+    put(header, quint32(4));
+    put(header, riffSize(frameCount));
+  }
+  header += "data";
+  put(header, riffSize(dataSize));
+  return header;
+}
+
+bool chrishenx::writeAudio(QIODevice* device, BinaryEncoder& encoder, const QVector<WaveformTrack>& tracks,
+                           int sampleRate, SampleFormat format, bool wav)
+{
+  const qint64 bitCount = encoder.bitCount();
+  const double transSpeed = encoder.transSpeed();
+  const int channelCount = tracks.size();
+  if (wav)
+  {
+    const QByteArray header = wavHeader(format, channelCount, sampleRate,
+                                        sampleAtBit(bitCount, transSpeed, sampleRate));
+    if (device->write(header) != header.size())
+    {
+      return false;
+    }
+  }
+  // Blocks of at most AUDIO_BLOCK_FRAMES frames that span about as many bits at most, a bit can be
+  // split between blocks and a frame never is
+  const qint64 frameTotal = sampleAtBit(bitCount, transSpeed, sampleRate);
+  const double bitsPerFrame = transSpeed / sampleRate;
+  const qint64 blockFrames = bitsPerFrame <= 1 ? AUDIO_BLOCK_FRAMES
+                                               : qMax(qint64(1), qint64(AUDIO_BLOCK_FRAMES / bitsPerFrame));
+  QByteArray block;
+  for (qint64 firstFrame = 0; firstFrame < frameTotal; firstFrame += blockFrames)
+  {
+    const qint64 frameCount = qMin(blockFrames, frameTotal - firstFrame);
+    // The bits under the first and the last sample, one more before in case of rounding
+    const qint64 first = qBound(qint64(0), qint64((firstFrame + 0.5) * bitsPerFrame) - 1, bitCount - 1);
+    const qint64 last = qBound(first, qint64((firstFrame + frameCount - 0.5) * bitsPerFrame), bitCount - 1);
+    const qint64 count = last - first + 1;
+    block.resize(int(frameCount * channelCount * sampleSize(format)));
+    for (int channel = 0; channel < channelCount; ++channel)
+    {
+      const BinaryEncoder::Data points = encoder.encodeRange(tracks[channel].method, first, count,
+                                                             tracks[channel].levels);
+      if (format == SampleFormat::INT16)
+      {
+        writePcm(points, firstFrame, frameCount, sampleRate, encoder.amplitude(),
+                 reinterpret_cast<qint16*>(block.data()) + channel, channelCount);
+      }
+      else
+      {
+        writePcm(points, firstFrame, frameCount, sampleRate, encoder.amplitude(),
+                 reinterpret_cast<float*>(block.data()) + channel, channelCount);
+      }
+    }
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    if (wav)
+    {
+      char* sample = block.data();
+      for (int i = 0; i < block.size(); i += sampleSize(format))
+      {
+        std::reverse(sample + i, sample + i + sampleSize(format));
+      }
+    }
+#endif
+    if (device->write(block) != block.size())
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool chrishenx::writeCsv(QIODevice* device, BinaryEncoder& encoder, const QVector<WaveformTrack>& tracks,
+                         const QList<QByteArray>& labels, char separator, bool edgesOnly, qint64 chunkBits)
+{
+  QByteArray header(CSV_HEADER);
+  header.replace(',', separator);
+  if (device->write(header) != header.size())
+  {
+    return false;
+  }
+  // Checkpoints hold one multilevel level count, the other methods ignore it
+  int levels = BinaryEncoder::DEFAULT_LEVELS;
+  for (const WaveformTrack& track : tracks)
+  {
+    if (track.method == BinaryEncoder::Method::MULTILEVEL)
+    {
+      levels = track.levels;
+    }
+  }
+  encoder.buildCheckpoints(levels);
+  const BinaryEncoder& shared = encoder;
+  const qint64 bitCount = encoder.bitCount();
+  auto formatChunk = [&](qint64 first)
+  {
+    const qint64 count = qMin(chunkBits, bitCount - first);
+    QByteArray text;
+    BinaryEncoder::Data points;
+    for (int i = 0; i < tracks.size(); ++i)
+    {
+      const BinaryEncoder::Method method = tracks[i].method;
+      const int pointsPerBit = BinaryEncoder::pointsPerBit(method);
+      double previousLevel = qQNaN();
+      if (edgesOnly && first > 0)
+      { // The level the chunk starts from is the one the bit before ends at
+        points.resize(pointsPerBit + 1);
+        const qint64 size = shared.encodeRangeInto(method, first - 1, 1, levels, points.data());
+        previousLevel = points[int(size) - 1].second;
+      }
+      points.resize(int(count * pointsPerBit + 1));
+      points.resize(int(shared.encodeRangeInto(method, first, count, levels, points.data())));
+      appendRows(text, points, labels[i], separator, edgesOnly, previousLevel);
+    }
+    return text;
+  };
+
+  const int ahead = 2 * QThreadPool::globalInstance()->maxThreadCount();
+  QList<QFuture<QByteArray>> chunks;
+  qint64 next = 0;
+  bool written = true;
+  while (written && (next < bitCount || !chunks.isEmpty()))
+  {
+    for (; next < bitCount && chunks.size() < ahead; next += chunkBits)
+    {
+      const qint64 first = next;
+      chunks << QtConcurrent::run([=]() { return formatChunk(first); });
+    }
+    const QByteArray text = chunks.takeFirst().result();
+    written = device->write(text) == text.size();
+  }
+  for (QFuture<QByteArray>& chunk : chunks)
+  { // They use the encoder and the tracks
+    chunk.waitForFinished();
+  }
+  return written;
+}
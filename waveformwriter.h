@@ -0,0 +1,89 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2015 Christian González León
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+  */
+
+#ifndef WAVEFORMWRITER_H
+#define WAVEFORMWRITER_H
+
+#include "binaryencoder.h"
+#include "waveformfile.h"
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QList>
+
+namespace chrishenx {
+
+  // Encoded points to the bytes of the output formats. A message can be converted chunk by chunk,
+  // the outputs of its chunks concatenated are the output of the whole message.
+
+  // Time and level of every point as native endian doubles
+  QByteArray toVertices(const BinaryEncoder::Data& points);
+
+  // One "label,time,level" line per point, CSV_HEADER names the columns. The numbers have 12
+  // significant digits
+  static const char CSV_HEADER[] = "method,time,level\n";
+  QByteArray toCsv(const BinaryEncoder::Data& points, const QByteArray& label, char separator = ',');
+
+  // Signed 16 bit native endian samples of the signal, full scale is amplitude. Sample n is taken
+  // at (n + 0.5) / sampleRate seconds, the points must cover the samples asked for
+  QByteArray toPcm(const BinaryEncoder::Data& points, qint64 firstSample, qint64 sampleCount,
+                   double sampleRate, double amplitude);
+  // The same samples into out, stride samples apart so they can land on a channel of a frame
+  void writePcm(const BinaryEncoder::Data& points, qint64 firstSample, qint64 sampleCount,
+                double sampleRate, double amplitude, qint16* out, int stride = 1);
+  // Or as floats, full scale being 1
+  void writePcm(const BinaryEncoder::Data& points, qint64 firstSample, qint64 sampleCount,
+                double sampleRate, double amplitude, float* out, int stride = 1);
+  // Mono sample buffers of the same length to one multichannel buffer
+  QByteArray interleavePcm(const QList<QByteArray>& channels);
+
+  enum class SampleFormat { INT16, FLOAT32 };
+
+  int sampleSize(SampleFormat format); // In bytes
+  // Index of the first sample at or after the start of a bit
+  qint64 sampleAtBit(qint64 bit, double transSpeed, double sampleRate);
+  // RIFF WAVE header for frameCount frames of channelCount samples. Sizes past 4 GiB are written as
+  // 0xFFFFFFFF, which most readers take as up to the end of the file
+  QByteArray wavHeader(SampleFormat format, int channelCount, int sampleRate, qint64 frameCount);
+
+  // Every track of the message as a channel of samples, rendered and written to the device in
+  // blocks of at most AUDIO_BLOCK_FRAMES frames. With a WAV header the samples are little endian,
+  // otherwise native endian
+  static const qint64 AUDIO_BLOCK_FRAMES = 1 << 20;
+  bool writeAudio(QIODevice* device, BinaryEncoder& encoder, const QVector<WaveformTrack>& tracks,
+                  int sampleRate, SampleFormat format, bool wav);
+
+  // The header and the rows of every track of the message, labeled as labels says, separated by
+  // separator. With edgesOnly a row is written only where the level changes. Chunks of chunkBits
+  // bits are encoded and formatted on the global thread pool, a couple of them a thread ahead of
+  // the one being written, and written in order
+  static const qint64 CSV_CHUNK_BITS = 1 << 16;
+  bool writeCsv(QIODevice* device, BinaryEncoder& encoder, const QVector<WaveformTrack>& tracks,
+                const QList<QByteArray>& labels, char separator = ',', bool edgesOnly = false,
+                qint64 chunkBits = CSV_CHUNK_BITS);
+
+} // chrishenx namespace end
+
+
+#endif // WAVEFORMWRITER_H
@@ -0,0 +1,26 @@
+# Main window and its plots, shared by the application and the latency harness. It needs the
+# encoding core of encoder.pri besides QtWidgets and QtPrintSupport
+
+QT += widgets printsupport concurrent
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/qcustomplot/qcustomplot.cpp \
+    $$PWD/bitticker.cpp \
+    $$PWD/bitviewer.cpp \
+    $$PWD/encodingjob.cpp \
+    $$PWD/mainwindow.cpp \
+    $$PWD/waveformtiles.cpp \
+    $$PWD/waveformvector.cpp
+
+HEADERS += \
+    $$PWD/mainwindow.h \
+    $$PWD/qcustomplot/qcustomplot.h \
+    $$PWD/bitticker.h \
+    $$PWD/bitviewer.h \
+    $$PWD/encodingjob.h \
+    $$PWD/waveformtiles.h \
+    $$PWD/waveformvector.h
+
+FORMS += $$PWD/mainwindow.ui